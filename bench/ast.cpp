@@ -0,0 +1,380 @@
+#include <string.h> // memcpy
+
+#include "util/system.h"
+
+#include "parser.h"
+
+#include "bench.h"
+
+namespace Thor {
+
+// The nodes of one kind laid out the way AstFile used to hold them, in a Slab:
+// pools of [capacity] nodes which are each allocated on their own, with the
+// index of a node decoded into its pool and the node in that pool by divisions.
+struct TraverseSlab {
+	TraverseSlab(Allocator& allocator, Ulen size, Ulen capacity)
+		: pools{allocator}
+		, size{size}
+		, capacity{capacity}
+	{
+	}
+	const Uint8* operator[](Uint32 index) const {
+		return pools[index / capacity].data() + size * (index % capacity);
+	}
+	Array<Array<Uint8>> pools;
+	Ulen                size;
+	Ulen                capacity;
+};
+
+// Read the location of every node of a parsed file in the order given by a list
+// of IDs, once through AstFile and once through a copy of the nodes laid out the
+// way AstFile used to hold them: a Slab of 4096 node pools for each kind with an
+// ID decoded into kind, pool and node by divisions. The IDs are read in the order
+// the nodes were made and in a random order.
+Bool bench_traverse(System& sys) {
+	static constexpr const Ulen RUNS = 5;
+
+	const auto& options = bench_options();
+	auto corpus = bench_corpus(sys.allocator, options.size, 1);
+	if (corpus.is_empty()) {
+		return false;
+	}
+	SourceManager sources{sys};
+	Diagnostics diagnostics{sys, sources};
+	auto parser = Parser::create(sys, sources, diagnostics, "corpus.odin", move(corpus));
+	if (!parser) {
+		return false;
+	}
+	auto stmts = parser->parse_all(1);
+	if (!stmts || !parser->is_done()) {
+		return false;
+	}
+	const auto& ast = parser->ast();
+
+	// Copy the nodes of every kind into a slab, each node has an ID for either
+	// layout.
+	struct ID {
+		Uint32 region;
+		Uint32 slab;
+	};
+	Array<ID> ids{sys.allocator};
+	Array<TraverseSlab> slabs{sys.allocator};
+	if (!ids.reserve(ast.nodes()) || !slabs.reserve(AstNodeTypes::LENGTH)) {
+		return false;
+	}
+	for (Uint32 kind = 0; kind < AstNodeTypes::LENGTH; kind++) {
+		const auto& region = ast.nodes(kind);
+		const auto size = region ? region->size() : 0;
+		if (!slabs.emplace_back(sys.allocator, size, Ulen(AstNode::MAX))) {
+			return false;
+		}
+		if (!region) {
+			continue;
+		}
+		auto& slab = slabs.last();
+		for (Uint32 i = 0; i < region->length(); i++) {
+			if (i % AstNode::MAX == 0) {
+				if (!slab.pools.emplace_back(sys.allocator) || !slab.pools.last().resize(size * AstNode::MAX)) {
+					return false;
+				}
+			}
+			auto& pool = slab.pools.last();
+			memcpy(pool.data() + size * (i % AstNode::MAX), (*region)[i], size);
+			if (!ids.push_back({ (kind << AstFile::SHIFT) | i, kind * AstFile::MAX + i })) {
+				return false;
+			}
+		}
+	}
+	Array<ID> shuffled{sys.allocator};
+	if (!shuffled.resize(ids.length())) {
+		return false;
+	}
+	for (Ulen i = 0; i < ids.length(); i++) {
+		shuffled[i] = ids[i];
+	}
+	BenchRandom random{1};
+	for (Ulen i = shuffled.length(); i > 1; i--) {
+		const auto j = random.range(Uint32(i));
+		const auto swap = shuffled[i - 1];
+		shuffled[i - 1] = shuffled[j];
+		shuffled[j] = swap;
+	}
+
+	auto report = [&](StringView order, StringView result, Float64 value, StringView unit) {
+		ScratchAllocator<64> scratch{sys.allocator};
+		StringBuilder name{scratch};
+		name.put("traverse.");
+		name.put(order);
+		name.put(result);
+		if (auto string = name.result()) {
+			bench_report(sys, *string, value, unit);
+		}
+	};
+	auto traverse = [&](StringView name, Slice<ID> order) {
+		Uint64 region_sum = 0;
+		const auto region_time = bench_best(sys, RUNS, [&] {
+			Uint64 sum = 0;
+			for (const auto id : order) {
+				sum += ast[AstRef<AstNode>{AstID{id.region}}].offset;
+			}
+			bench_keep(sum);
+			region_sum = sum;
+		});
+		Uint64 slab_sum = 0;
+		const auto slab_time = bench_best(sys, RUNS, [&] {
+			Uint64 sum = 0;
+			for (const auto id : order) {
+				const auto& slab = slabs[id.slab / AstFile::MAX];
+				sum += reinterpret_cast<const AstNode*>(slab[id.slab % AstFile::MAX])->offset;
+			}
+			bench_keep(sum);
+			slab_sum = sum;
+		});
+		if (region_sum != slab_sum) {
+			bench_report(sys, "traverse.mismatch", Float64(order.length()), "nodes");
+			return false;
+		}
+		report(name, ".slab", slab_time.value() * 1e3, "ms");
+		report(name, ".region", region_time.value() * 1e3, "ms");
+		report(name, ".speedup", slab_time.value() / region_time.value(), "x");
+		return true;
+	};
+
+	bench_report(sys, "traverse.nodes", Float64(ids.length()), "nodes");
+	return traverse("sequential", ids.slice())
+	    && traverse("shuffled", shuffled.slice());
+}
+
+// Time listing the trees of a parsed file in pre-order with AstFile::linearise
+// and a forward scan over the result which reads the location of every node. The
+// scan is timed again skipping the subtree of every procedure literal, the way a
+// pass which only looks at declarations would. The list is checked to be a
+// valid pre-order.
+Bool bench_linearise(System& sys) {
+	static constexpr const Ulen RUNS = 5;
+
+	const auto& options = bench_options();
+	auto corpus = bench_corpus(sys.allocator, options.size, 1);
+	if (corpus.is_empty()) {
+		return false;
+	}
+	SourceManager sources{sys};
+	Diagnostics diagnostics{sys, sources};
+	auto parser = Parser::create(sys, sources, diagnostics, "corpus.odin", move(corpus));
+	if (!parser) {
+		return false;
+	}
+	auto stmts = parser->parse_all(1);
+	if (!stmts || !parser->is_done()) {
+		return false;
+	}
+	const auto& ast = parser->ast();
+	const auto roots = Slice<const AstRef<AstStmt>> { stmts->data(), stmts->length() };
+
+	Maybe<AstLinear> linear;
+	const auto build = bench_best(sys, RUNS, [&] {
+		if (auto result = ast.linearise(roots)) {
+			linear = move(*result);
+		}
+	});
+	if (!linear) {
+		return false;
+	}
+
+	// Every subtree must end within that of its parent and the roots must cover
+	// the whole list.
+	Ulen covered = 0;
+	for (Ulen i = 0; i < linear->length(); i++) {
+		const auto& node = (*linear)[i];
+		if (node.parent == AstLinear::NONE) {
+			covered += node.size;
+		} else if (node.parent >= i || linear->skip(i) > linear->skip(node.parent)) {
+			bench_report(sys, "linearise.invalid", Float64(i), "index");
+			return false;
+		}
+	}
+	if (covered != linear->length()) {
+		bench_report(sys, "linearise.invalid", Float64(covered), "nodes");
+		return false;
+	}
+
+	// Read every node, then skip the subtree of every procedure literal.
+	auto scan = [&](Uint32 skip) {
+		return bench_best(sys, RUNS, [&] {
+			Uint64 sum = 0;
+			for (Ulen i = 0; i < linear->length(); /**/) {
+				const auto& node = (*linear)[i];
+				sum += ast[AstRef<AstNode>{node.id}].offset;
+				i = node.kind == skip ? linear->skip(i) : i + 1;
+			}
+			bench_keep(sum);
+		});
+	};
+	const auto all = scan(AstLinear::NONE);
+	const auto decls = scan(AstSlabID::id<AstProcExpr>());
+
+	bench_report(sys, "linearise.nodes", Float64(linear->length()), "nodes");
+	bench_report(sys, "linearise.build", build.value() * 1e3, "ms");
+	bench_report(sys, "linearise.scan", all.value() * 1e3, "ms");
+	bench_report(sys, "linearise.skim", decls.value() * 1e3, "ms");
+
+	return true;
+}
+
+// Walk the trees of a parsed file with AstFile::walk. A pass with only enter
+// hooks counts the expressions, types, statements and other nodes, and a pass
+// with leave hooks as well finds how deep the trees go. Both are checked to
+// reach every node in the same order as AstFile::linearise.
+Bool bench_walk(System& sys) {
+	static constexpr const Ulen RUNS = 5;
+
+	const auto& options = bench_options();
+	auto corpus = bench_corpus(sys.allocator, options.size, 1);
+	if (corpus.is_empty()) {
+		return false;
+	}
+	SourceManager sources{sys};
+	Diagnostics diagnostics{sys, sources};
+	auto parser = Parser::create(sys, sources, diagnostics, "corpus.odin", move(corpus));
+	if (!parser) {
+		return false;
+	}
+	auto stmts = parser->parse_all(1);
+	if (!stmts || !parser->is_done()) {
+		return false;
+	}
+	const auto& ast = parser->ast();
+	const auto roots = Slice<const AstRef<AstStmt>> { stmts->data(), stmts->length() };
+	auto linear = ast.linearise(roots);
+	if (!linear) {
+		return false;
+	}
+
+	struct Count {
+		void enter(const AstExpr&, AstRef<AstNode>) { exprs++; }
+		void enter(const AstType&, AstRef<AstNode>) { types++; }
+		void enter(const AstStmt&, AstRef<AstNode>) { stmts++; }
+		void enter(const AstNode&, AstRef<AstNode>) { others++; }
+		Ulen total() const { return exprs + types + stmts + others; }
+		Ulen exprs  = 0;
+		Ulen types  = 0;
+		Ulen stmts  = 0;
+		Ulen others = 0;
+	};
+	struct Depth {
+		void enter(const AstNode&, AstRef<AstNode>) {
+			if (++depth > deepest) {
+				deepest = depth;
+			}
+		}
+		void leave(const AstNode&, AstRef<AstNode>) {
+			depth--;
+		}
+		Ulen depth   = 0;
+		Ulen deepest = 0;
+	};
+	struct Order {
+		Bool enter(const AstNode& node, AstRef<AstNode>) {
+			same = same && index < linear.length() && &node == &ast[AstRef<AstNode>{linear[index].id}];
+			index++;
+			return true;
+		}
+		const AstFile&   ast;
+		const AstLinear& linear;
+		Ulen             index = 0;
+		Bool             same  = true;
+	};
+
+	Order order{ast, *linear};
+	if (!ast.walk(roots, order) || !order.same || order.index != linear->length()) {
+		bench_report(sys, "walk.mismatch", Float64(order.index), "nodes");
+		return false;
+	}
+
+	Count count;
+	Bool ok = true;
+	const auto enter = bench_best(sys, RUNS, [&] {
+		count = {};
+		ok = ok && ast.walk(roots, count);
+	});
+	Depth depth;
+	const auto leave = bench_best(sys, RUNS, [&] {
+		depth = {};
+		ok = ok && ast.walk(roots, depth);
+	});
+	if (!ok || count.total() != linear->length() || depth.depth != 0) {
+		bench_report(sys, "walk.mismatch", Float64(count.total()), "nodes");
+		return false;
+	}
+
+	bench_report(sys, "walk.exprs", Float64(count.exprs), "nodes");
+	bench_report(sys, "walk.types", Float64(count.types), "nodes");
+	bench_report(sys, "walk.stmts", Float64(count.stmts), "nodes");
+	bench_report(sys, "walk.others", Float64(count.others), "nodes");
+	bench_report(sys, "walk.depth", Float64(depth.deepest), "nodes");
+	bench_report(sys, "walk.enter", enter.value() * 1e3, "ms");
+	bench_report(sys, "walk.leave", leave.value() * 1e3, "ms");
+
+	return true;
+}
+
+// Count the uses of types in a parsed file and the type nodes behind them, which
+// are fewer as the same spelling of a type is shared, see AstTypeKey. Parsing on
+// several threads merges the pieces and must share just as many.
+Bool bench_share(System& sys) {
+	struct Types {
+		void enter(const AstType& type, AstRef<AstNode>) {
+			uses++;
+			const auto address = reinterpret_cast<Address>(&type);
+			if (!seen.find(address)) {
+				ok = ok && seen.insert(address, 0);
+			}
+		}
+		Map<Address, Uint32> seen;
+		Ulen                uses = 0;
+		Bool                ok   = true;
+	};
+
+	const auto& options = bench_options();
+	const auto corpus = bench_corpus(sys.allocator, options.size, 1);
+	if (corpus.is_empty()) {
+		return false;
+	}
+	SourceManager sources{sys};
+	Diagnostics diagnostics{sys, sources};
+
+	// The types of a piece which are already shared are not copied when it is
+	// merged, so there are as many nodes as there are on one thread.
+	Ulen expected = 0;
+	Uint64 nodes = 0;
+	for (Ulen threads = 1; threads <= options.threads; threads *= 2) {
+		auto parse_sys = sys.clone();
+		auto parser = Parser::create(parse_sys, sources, diagnostics, "corpus.odin", bench_copy(parse_sys.allocator, corpus.slice()));
+		if (!parser) {
+			return false;
+		}
+		auto stmts = parser->parse_all(threads);
+		if (!stmts || !parser->is_done()) {
+			return false;
+		}
+		const auto roots = Slice<const AstRef<AstStmt>> { stmts->data(), stmts->length() };
+		Types types{{parse_sys.allocator}};
+		if (!parser->ast().walk(roots, types) || !types.ok) {
+			return false;
+		}
+		if (threads == 1) {
+			expected = types.seen.length();
+			nodes = parser->ast().nodes();
+			bench_report(sys, "share.uses", Float64(types.uses), "types");
+			bench_report(sys, "share.nodes", Float64(types.seen.length()), "types");
+			bench_report(sys, "share.ratio", Float64(types.uses) / Float64(types.seen.length()), "x");
+		} else if (types.seen.length() != expected || parser->ast().nodes() != nodes) {
+			bench_report(sys, "share.mismatch", Float64(threads), "threads");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace Thor
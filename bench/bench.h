@@ -0,0 +1,79 @@
+#ifndef THOR_BENCH_H
+#define THOR_BENCH_H
+#include "util/system.h"
+#include "util/time.h"
+
+namespace Thor {
+
+// Small deterministic generator (splitmix64) so that every run of a benchmark
+// sees exactly the same input.
+struct BenchRandom {
+	constexpr BenchRandom(Uint64 seed)
+		: state_{seed}
+	{
+	}
+	Uint64 next() {
+		auto z = (state_ += 0x9e3779b97f4a7c15_u64);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9_u64;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb_u64;
+		return z ^ (z >> 31);
+	}
+	// Uniform in [0, n)
+	Uint32 range(Uint32 n) {
+		return Uint32((Uint64(Uint32(next())) * n) >> 32);
+	}
+private:
+	Uint64 state_;
+};
+
+// Time [fn] [runs] times and return the fastest run.
+template<typename F>
+Seconds bench_best(System& sys, Ulen runs, F&& fn) {
+	Seconds best{0.0};
+	for (Ulen i = 0; i < runs; i++) {
+		const auto beg = MonotonicTime::now(sys);
+		fn();
+		const auto elapsed = MonotonicTime::now(sys) - beg;
+		if (i == 0 || elapsed.value() < best.value()) {
+			best = elapsed;
+		}
+	}
+	return best;
+}
+
+// Stop the compiler from discarding a computation whose result is unused.
+template<typename T>
+THOR_FORCEINLINE void bench_keep(const T& value) {
+#if defined(THOR_COMPILER_MSVC)
+	static volatile T sink;
+	sink = value;
+#else
+	asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+// Options given to the benchmarks on the command line as -name=value.
+struct BenchOptions {
+	Ulen       size    = 16 * 1024 * 1024; // -size=16M, the size of generated input
+	Ulen       threads = 8;                // -threads=8, the most threads to use
+	StringView save;                       // -save=FILE, write every result to FILE
+	StringView baseline;                   // -baseline=FILE, compare to those in FILE
+};
+const BenchOptions& bench_options();
+
+// Write one line of the form "name: value unit" to the console. When there is a
+// baseline with the same result in it the change from that is written as well.
+void bench_report(System& sys, StringView name, Float64 value, StringView unit);
+
+// Copy [bytes] into an array of [allocator] for a Lexer or Parser to take. The
+// result is empty when out of memory.
+Array<Uint8> bench_copy(Allocator& allocator, Slice<const Uint8> bytes);
+
+// Generate a file of at least [size] bytes of Odin source which reads like that
+// of a real package and parses without error. Each [seed] gives a different file.
+// The result is empty when out of memory.
+Array<Uint8> bench_corpus(Allocator& allocator, Ulen size, Uint64 seed);
+
+} // namespace Thor
+
+#endif // THOR_BENCH_H
@@ -0,0 +1,401 @@
+#include "util/system.h"
+
+#include "bench.h"
+
+namespace Thor {
+
+// Writes one file of the corpus. The source is meant to look like the code of a
+// real package: declarations of procedures, structs, enums and constants with
+// comments around them, procedure bodies of nested control flow, and the odd
+// long expression or string literal, all of which the parser accepts.
+struct CorpusWriter {
+	CorpusWriter(Array<Uint8>& out, Uint64 seed)
+		: out_{out}
+		, random_{seed}
+	{
+	}
+
+	Bool file(Ulen size) {
+		put("package corpus\n\nimport \"core:fmt\"\nimport \"core:mem\"\n\n");
+		for (Ulen n = 0; ok_ && out_.length() < size; n++) {
+			switch (random_.range(8)) {
+			case 0:
+				struct_decl();
+				break;
+			case 1:
+				enum_decl();
+				break;
+			case 2:
+				constant_decl();
+				break;
+			case 3:
+				block_comment();
+				break;
+			default:
+				proc_decl();
+				break;
+			}
+			put('\n');
+		}
+		return ok_;
+	}
+
+private:
+	static constexpr const StringView WORDS[] = {
+		"item", "count", "value", "index", "node", "buffer", "length", "offset",
+		"result", "total", "entry", "name", "size", "data", "next", "prev",
+		"left", "right", "key", "hash", "first", "last", "width", "height",
+	};
+	static constexpr const StringView TYPES[] = {
+		"int", "uint", "i32", "u8", "f32", "f64", "bool", "string", "rawptr",
+		"[]int", "^Node", "[4]f32", "[dynamic]string", "map[string]int",
+	};
+	static constexpr const StringView STRINGS[] = {
+		"\"hello, world\\n\"", "\"%d items in %s\\n\"", "\"tab\\tseparated\\tvalues\"",
+		"\"a \\\"quoted\\\" word\"", "`C:\\raw\\path`", "\"unicode \\u00e9\\u00e8\"",
+		"\"\"", "\"a much longer string literal which goes on for a while to be realistic\"",
+	};
+	static constexpr const StringView BINARY[] = {
+		" + ", " - ", " * ", " / ", " % ", " & ", " | ", " ~ ", " << ", " >> ",
+	};
+	static constexpr const StringView COMPARE[] = {
+		" == ", " != ", " < ", " <= ", " > ", " >= ",
+	};
+	static constexpr const StringView ASSIGN[] = {
+		" = ", " += ", " -= ", " *= ", " |= ",
+	};
+
+	void put(char ch) {
+		ok_ = ok_ && out_.push_back(Uint8(ch));
+	}
+	void put(StringView string) {
+		for (auto ch : string) put(ch);
+	}
+	void put(Uint64 value) {
+		char digits[20];
+		Ulen n = 0;
+		do digits[n++] = char('0' + value % 10); while (value /= 10);
+		while (n) put(digits[--n]);
+	}
+	template<Ulen E>
+	StringView choose(const StringView (&strings)[E]) {
+		return strings[random_.range(E)];
+	}
+	template<Ulen E>
+	void pick(const StringView (&strings)[E]) {
+		put(choose(strings));
+	}
+	void indent(Ulen depth) {
+		for (Ulen i = 0; i < depth; i++) put('\t');
+	}
+
+	void ident() {
+		pick(WORDS);
+		if (random_.range(3) == 0) {
+			put('_');
+			pick(WORDS);
+		}
+	}
+	void type_name() {
+		const auto word = choose(WORDS);
+		put(char(word[0] - 'a' + 'A'));
+		put(word.slice(1));
+	}
+	void number() {
+		switch (random_.range(4)) {
+		case 0:  put(Uint64(random_.range(1000))); break;
+		case 1:  put("0x"); put(Uint64(random_.range(10)) + 1); put("f"); break;
+		case 2:  put(Uint64(random_.range(100))); put('.'); put(Uint64(random_.range(1000))); break;
+		default: put(Uint64(random_.range(1 << 20))); break;
+		}
+	}
+	void literal() {
+		switch (random_.range(4)) {
+		case 0:  pick(STRINGS); break;
+		case 1:  put(random_.range(2) ? StringView { "true" } : StringView { "false" }); break;
+		default: number(); break;
+		}
+	}
+	void operand(Ulen depth) {
+		switch (depth > 2 ? random_.range(3) : random_.range(7)) {
+		case 0:
+			ident();
+			break;
+		case 1:
+			number();
+			break;
+		case 2:
+			ident();
+			put('.');
+			ident();
+			break;
+		case 3:
+			ident();
+			put('[');
+			expr(depth + 1);
+			put(']');
+			break;
+		case 4:
+			call(depth + 1);
+			break;
+		case 5:
+			put('(');
+			expr(depth + 1);
+			put(')');
+			break;
+		default:
+			put(random_.range(2) ? '-' : '!');
+			ident();
+			break;
+		}
+	}
+	void expr(Ulen depth) {
+		operand(depth);
+		// Mostly short expressions with the odd very long one.
+		const auto terms = random_.range(16) == 0 ? 4 + random_.range(12) : random_.range(3);
+		for (Ulen i = 0; i < terms; i++) {
+			pick(BINARY);
+			operand(depth);
+		}
+	}
+	// Ends with a name or number as '(x) {' would read as a compound literal.
+	void condition(Ulen depth) {
+		expr(depth);
+		if (random_.range(4) == 0) {
+			pick(COMPARE);
+			ident();
+			put(random_.range(2) ? StringView { " && " } : StringView { " || " });
+			expr(depth);
+		}
+		pick(COMPARE);
+		if (random_.range(2)) {
+			ident();
+		} else {
+			number();
+		}
+	}
+	void call(Ulen depth) {
+		if (random_.range(2)) {
+			put(random_.range(2) ? StringView { "fmt." } : StringView { "mem." });
+		}
+		ident();
+		put('(');
+		const auto args = random_.range(4);
+		for (Ulen i = 0; i < args; i++) {
+			if (i) put(", ");
+			if (random_.range(4) == 0) {
+				literal();
+			} else {
+				expr(depth + 1);
+			}
+		}
+		put(')');
+	}
+
+	void comment(Ulen depth) {
+		indent(depth);
+		put("// ");
+		const auto words = 3 + random_.range(10);
+		for (Ulen i = 0; i < words; i++) {
+			if (i) put(' ');
+			pick(WORDS);
+		}
+		put('\n');
+	}
+	void block_comment() {
+		put("/*\n");
+		const auto lines = 1 + random_.range(6);
+		for (Ulen i = 0; i < lines; i++) {
+			put("\t");
+			const auto words = 4 + random_.range(10);
+			for (Ulen j = 0; j < words; j++) {
+				if (j) put(' ');
+				pick(WORDS);
+			}
+			put('\n');
+		}
+		put("*/\n");
+	}
+	void doc_comment() {
+		const auto lines = random_.range(4);
+		for (Ulen i = 0; i < lines; i++) {
+			comment(0);
+		}
+	}
+
+	void block(Ulen depth) {
+		put(" {\n");
+		const auto stmts = 1 + random_.range(depth > 2 ? 3 : 6);
+		for (Ulen i = 0; i < stmts; i++) {
+			stmt(depth + 1);
+		}
+		indent(depth);
+		put('}');
+	}
+	void stmt(Ulen depth) {
+		switch (depth > 3 ? random_.range(4) : random_.range(12)) {
+		case 0:
+			indent(depth);
+			ident();
+			put(" := ");
+			expr(0);
+			break;
+		case 1:
+			indent(depth);
+			ident();
+			pick(ASSIGN);
+			expr(0);
+			break;
+		case 2:
+			indent(depth);
+			call(0);
+			break;
+		case 3:
+			comment(depth);
+			return;
+		case 4:
+			indent(depth);
+			put("if ");
+			condition(0);
+			block(depth);
+			if (random_.range(2)) {
+				put(" else");
+				block(depth);
+			}
+			break;
+		case 5:
+			indent(depth);
+			put("for ");
+			ident();
+			put(" in 0..<");
+			ident();
+			block(depth);
+			break;
+		case 6:
+			indent(depth);
+			put("for i := 0; i < ");
+			number();
+			put("; i += 1");
+			block(depth);
+			break;
+		case 7:
+			indent(depth);
+			put("defer ");
+			call(0);
+			break;
+		case 8:
+			indent(depth);
+			ident();
+			put(" := []");
+			type_name();
+			put(" {\n");
+			for (Ulen i = 0, n = 1 + random_.range(6); i < n; i++) {
+				indent(depth + 1);
+				put('{');
+				pick(STRINGS);
+				put(", ");
+				put(Uint64(random_.range(500)));
+				put(", ");
+				put(Uint64(random_.range(500)));
+				put("},\n");
+			}
+			indent(depth);
+			put('}');
+			break;
+		case 9:
+			indent(depth);
+			put("when ODIN_DEBUG");
+			block(depth);
+			break;
+		case 10:
+			indent(depth);
+			put("for ");
+			ident();
+			put(", i in ");
+			ident();
+			block(depth);
+			break;
+		default:
+			indent(depth);
+			put("return ");
+			expr(0);
+			break;
+		}
+		if (random_.range(8) == 0) {
+			put(" // ");
+			pick(WORDS);
+		}
+		put('\n');
+	}
+
+	void proc_decl() {
+		doc_comment();
+		ident();
+		put(" :: proc(");
+		const auto params = random_.range(5);
+		for (Ulen i = 0; i < params; i++) {
+			if (i) put(", ");
+			ident();
+			put(": ");
+			pick(TYPES);
+		}
+		put(')');
+		if (random_.range(2)) {
+			put(" -> ");
+			pick(TYPES);
+		}
+		block(0);
+		put('\n');
+	}
+	void struct_decl() {
+		doc_comment();
+		type_name();
+		put(" :: struct {\n");
+		const auto fields = 1 + random_.range(8);
+		for (Ulen i = 0; i < fields; i++) {
+			put('\t');
+			ident();
+			put(": ");
+			pick(TYPES);
+			put(",\n");
+		}
+		put("}\n");
+	}
+	void enum_decl() {
+		doc_comment();
+		type_name();
+		put(" :: enum {\n");
+		const auto values = 1 + random_.range(10);
+		for (Ulen i = 0; i < values; i++) {
+			put('\t');
+			type_name();
+			put(",\n");
+		}
+		put("}\n");
+	}
+	void constant_decl() {
+		doc_comment();
+		ident();
+		put(" :: ");
+		expr(0);
+		put('\n');
+	}
+
+	Array<Uint8>& out_;
+	BenchRandom   random_;
+	Bool          ok_ = true;
+};
+
+Array<Uint8> bench_corpus(Allocator& allocator, Ulen size, Uint64 seed) {
+	Array<Uint8> source{allocator};
+	if (!source.reserve(size + size / 8)) {
+		return source;
+	}
+	CorpusWriter writer{source, seed};
+	if (!writer.file(size)) {
+		source.clear();
+	}
+	return source;
+}
+
+} // namespace Thor
@@ -0,0 +1,145 @@
+#include "util/system.h"
+
+#include "lexer.h"
+
+#include "bench.h"
+
+namespace Thor {
+
+// The linear search the lexer used before reserved words were looked up with a
+// perfect hash, kept here as the baseline to compare against.
+static Token linear_identifier(StringView str, Uint32 beg, Uint16 len) {
+	static constexpr const struct {
+		StringView   match;
+		OperatorKind kind;
+	} OPERATORS[] = {
+		#define OPERATOR_true(ENUM, MATCH) \
+			{ MATCH, OperatorKind::ENUM },
+		#define OPERATOR_false(...)
+		#define OPERATOR(ENUM, NAME, MATCH, PREC, NAMED, ASI) \
+			OPERATOR_ ## NAMED (ENUM, MATCH)
+		#include "lexer.inl"
+		#undef OPERATOR_true
+		#undef OPERATOR_false
+	};
+	for (Ulen i = 0; i < countof(OPERATORS); i++) {
+		if (const auto& op = OPERATORS[i]; op.match == str) {
+			return { op.kind, beg, len };
+		}
+	}
+	static constexpr const struct {
+		StringView  match;
+		KeywordKind kind;
+	} KEYWORDS[] = {
+		#define KEYWORD(ENUM, MATCH, ASI) \
+			{ MATCH, KeywordKind::ENUM },
+		#include "lexer.inl"
+	};
+	for (Ulen i = 0; i < countof(KEYWORDS); i++) {
+		if (const auto& kw = KEYWORDS[i]; kw.match == str) {
+			return { kw.kind, beg, len };
+		}
+	}
+	return { TokenKind::IDENTIFIER, beg, len };
+}
+
+// Generate identifier heavy source: roughly one word in four is reserved and
+// the rest are identifiers of varying length.
+static Array<Uint8> generate(System& sys, Ulen size) {
+	static constexpr const StringView RESERVED[] = {
+		#define KEYWORD(ENUM, MATCH, ASI) MATCH,
+		#include "lexer.inl"
+	};
+	Array<Uint8> source{sys.allocator};
+	BenchRandom random{0x74686f72}; // "thor"
+	for (Ulen words = 0; source.length() < size; words++) {
+		if (random.range(4) == 0) {
+			for (auto ch : RESERVED[random.range(countof(RESERVED))]) {
+				if (!source.push_back(ch)) return {sys.allocator};
+			}
+		} else {
+			static constexpr const char CHARS[] = "abcdefghijklmnopqrstuvwxyz_";
+			const auto length = 1 + random.range(12);
+			for (Ulen i = 0; i < length; i++) {
+				if (!source.push_back(CHARS[random.range(countof(CHARS) - 1)])) return {sys.allocator};
+			}
+		}
+		if (!source.push_back(words % 8 == 7 ? '\n' : ' ')) {
+			return {sys.allocator};
+		}
+	}
+	return source;
+}
+
+Bool bench_keywords(System& sys) {
+	static constexpr const Ulen SIZE = 16 * 1024 * 1024;
+	static constexpr const Ulen RUNS = 5;
+
+	auto source = generate(sys, SIZE);
+	if (source.is_empty()) {
+		return false;
+	}
+
+	const auto length = Float64(source.length());
+	auto lexer = Lexer::create(move(source));
+	if (!lexer) {
+		return false;
+	}
+
+	// Collect every word the lexer had to classify.
+	Array<Token> words{sys.allocator};
+	for (;;) {
+		const auto token = lexer->next();
+		if (token.kind == TokenKind::ENDOF) {
+			break;
+		}
+		switch (token.kind) {
+		case TokenKind::IDENTIFIER:
+		case TokenKind::KEYWORD:
+		case TokenKind::OPERATOR:
+			if (!words.push_back(token)) {
+				return false;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	auto classify = [&](auto&& fn) {
+		Uint64 sum = 0;
+		for (const auto token : words) {
+			const auto result = fn(lexer->string(token), token.offset, token.length);
+			sum += Uint64(result.kind) + Uint64(result.length);
+		}
+		bench_keep(sum);
+	};
+
+	const auto linear = bench_best(sys, RUNS, [&] { classify(linear_identifier); });
+	const auto hashed = bench_best(sys, RUNS, [&] { classify(Lexer::identifier); });
+	const auto n = Float64(words.length());
+	bench_report(sys, "keywords.linear", linear.value() * 1e9 / n, "ns/word");
+	bench_report(sys, "keywords.hashed", hashed.value() * 1e9 / n, "ns/word");
+	bench_report(sys, "keywords.speedup", linear.value() / hashed.value(), "x");
+
+	// End to end lexing of the same input. The generator is deterministic so
+	// each run gets an identical fresh copy to hand to the lexer.
+	Seconds lex{0.0};
+	for (Ulen i = 0; i < RUNS; i++) {
+		auto input = Lexer::create(generate(sys, SIZE));
+		if (!input) {
+			return false;
+		}
+		const auto beg = MonotonicTime::now(sys);
+		while (input->next().kind != TokenKind::ENDOF);
+		const auto elapsed = MonotonicTime::now(sys) - beg;
+		if (i == 0 || elapsed.value() < lex.value()) {
+			lex = elapsed;
+		}
+	}
+	bench_report(sys, "keywords.lex", length / lex.value() / (1024.0 * 1024.0), "MiB/s");
+
+	return true;
+}
+
+} // namespace Thor
@@ -0,0 +1,259 @@
+#include "util/system.h"
+
+#include "lexer.h"
+
+#include "bench.h"
+
+namespace Thor {
+
+// Generate source which is awkward to split: comments and raw strings spanning
+// many lines, nested block comments, and lines which need a semicolon inserted
+// at the end.
+static Array<Uint8> generate(System& sys, Ulen size) {
+	static constexpr const StringView PIECES[] = {
+		"foo :: proc(a: int, b: f32) -> int {\n\tx := a + 1\n\treturn x\n}\n",
+		"// A line comment with \"quotes\" and `backticks`\n",
+		"// A doc comment\n// over two lines\nbar :: proc() {}\n",
+		"/* A block comment\n   spanning lines with a ` and a \" in it\n*/\n",
+		"/* Nested /* block\n comments */ still commented\n*/\n",
+		"s := \"a string with \\\"escapes\\\" and \\n\"\n",
+		"r := `a raw string\nwhich spans\nthree lines`\n",
+		"v := 0x1f + 0b1010 + 1.5e10 + 3i\n",
+		"if x <= 10 && y != 20 { z += 1 }\n",
+		"\n\n\t   \n",
+		"arr := [?]int{1, 2, 3,\n\t4, 5, 6}\n",
+		"x := y \\\n\t+ z\n",
+	};
+	Array<Uint8> source{sys.allocator};
+	BenchRandom random{0x6c657865}; // "lexe"
+	while (source.length() < size) {
+		for (auto ch : PIECES[random.range(countof(PIECES))]) {
+			if (!source.push_back(ch)) return {sys.allocator};
+		}
+		// Every so often open a comment or raw string which runs for a long way
+		// so that it will cross chunk boundaries.
+		if (random.range(2048) == 0) {
+			const auto kind = random.range(3);
+			if (kind == 2) {
+				// A block comment after a token which wants a semicolon, on a line
+				// long enough to hold a chunk boundary. The chunk after it starts on
+				// a line which begins with the end of the comment and then has
+				// another comment, where both lexers agree on the token but not on
+				// the pending semicolon.
+				for (auto ch : StringView { "x := 1 /*" }) if (!source.push_back(ch)) return {sys.allocator};
+				const auto words = random.range(64 * 1024);
+				for (Ulen i = 0; i < words; i++) {
+					for (auto ch : StringView { " all on one line" }) {
+						if (!source.push_back(ch)) return {sys.allocator};
+					}
+				}
+				for (auto ch : StringView { "\n*/ /* b */\ny := 2\n" }) {
+					if (!source.push_back(ch)) return {sys.allocator};
+				}
+				continue;
+			}
+			const auto raw = kind == 0;
+			const auto open = raw ? StringView { "`" } : StringView { "/*" };
+			const auto close = raw ? StringView { "`\n" } : StringView { "*/\n" };
+			for (auto ch : open) if (!source.push_back(ch)) return {sys.allocator};
+			const auto lines = random.range(64 * 1024);
+			for (Ulen i = 0; i < lines; i++) {
+				for (auto ch : StringView { "inside := 1 // not code\n" }) {
+					if (!source.push_back(ch)) return {sys.allocator};
+				}
+			}
+			for (auto ch : close) if (!source.push_back(ch)) return {sys.allocator};
+		}
+	}
+	return source;
+}
+
+// Tokens too long for Token::length have their length kept by the lexer, so
+// compare those through the lexers which produced them.
+static Bool same(const Lexer& lhs_lexer, const TokenStream& lhs,
+                 const Lexer& rhs_lexer, const TokenStream& rhs)
+{
+	auto equal = [&](Token a, Token b) {
+		return a == b && lhs_lexer.length(a) == rhs_lexer.length(b);
+	};
+	if (lhs.length() != rhs.length() || lhs.comments().length() != rhs.comments().length()) {
+		return false;
+	}
+	for (Ulen i = 0; i < lhs.length(); i++) {
+		if (!equal(lhs[i], rhs[i])) {
+			return false;
+		}
+	}
+	for (Ulen i = 0; i < lhs.comments().length(); i++) {
+		if (!equal(lhs.comments()[i], rhs.comments()[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// A lexer over a copy of the input of [lexer].
+static Maybe<Lexer> copy_lexer(Allocator& allocator, const Lexer& lexer) {
+	auto copy = bench_copy(allocator, lexer.input().cast<const Uint8>());
+	if (copy.length() != lexer.input().length()) {
+		return {};
+	}
+	return Lexer::create(move(copy));
+}
+
+Bool bench_lexer(System& sys) {
+	static constexpr const Ulen SIZE = 64 * 1024 * 1024;
+	static constexpr const Ulen RUNS = 3;
+	static constexpr const Ulen THREADS[] = { 2, 4, 8, 16 };
+
+	auto lexer = Lexer::create(generate(sys, SIZE));
+	if (!lexer) {
+		return false;
+	}
+	const auto size = Float64(lexer->input().length()) / (1024.0 * 1024.0 * 1024.0);
+
+	// The lexer is consumed by lexing, so every run starts from a fresh lexer over
+	// the same input.
+	auto fresh = [&] {
+		return copy_lexer(sys.allocator, *lexer);
+	};
+
+	// Time lexing alone, the copy for the fresh lexer is made beforehand.
+	auto best = [&](auto&& tokenize) {
+		Seconds best{0.0};
+		for (Ulen i = 0; i < RUNS; i++) {
+			auto input = fresh();
+			if (!input) {
+				continue;
+			}
+			const auto beg = MonotonicTime::now(sys);
+			bench_keep(tokenize(*input));
+			const auto elapsed = MonotonicTime::now(sys) - beg;
+			if (best.value() == 0.0 || elapsed.value() < best.value()) {
+				best = elapsed;
+			}
+		}
+		return best;
+	};
+
+	auto sequential = lexer->tokenize_all(sys.allocator);
+	if (!sequential) {
+		return false;
+	}
+	const auto time = best([&](Lexer& input) {
+		return input.tokenize_all(sys.allocator).is_valid();
+	});
+	bench_report(sys, "lexer.sequential", size / time.value(), "GiB/s");
+
+	for (const auto threads : THREADS) {
+		auto input = fresh();
+		if (!input) {
+			return false;
+		}
+		auto parallel = input->tokenize_parallel(sys, sys.allocator, threads);
+		if (!parallel || !same(*lexer, *sequential, *input, *parallel)) {
+			bench_report(sys, "lexer.parallel.mismatch", Float64(threads), "threads");
+			return false;
+		}
+		const auto time = best([&](Lexer& input) {
+			return input.tokenize_parallel(sys, sys.allocator, threads).is_valid();
+		});
+		ScratchAllocator<256> scratch{sys.allocator};
+		StringBuilder name{scratch};
+		name.put("lexer.parallel.");
+		name.put(Uint64(threads));
+		if (auto result = name.result()) {
+			bench_report(sys, *result, size / time.value(), "GiB/s");
+		}
+	}
+
+	return true;
+}
+
+// A random edit of [input]. Most are small but plenty change how the lexer sees
+// everything after them, like opening a comment or a string.
+static TextEdit random_edit(BenchRandom& random, StringView input) {
+	static constexpr const StringView INSERTS[] = {
+		"", "x", "count", " ", "\t", "\n", "1.5e3", "0x", "..<", "+", "-", "=",
+		"\"", "`", "/*", "*/", "//", "\\\n", "{", "}", "if x < 1 { y := 2 }\n",
+		"// A doc comment\nfoo :: proc() {}\n",
+	};
+	const auto length = Uint32(input.length());
+	const auto offset = random.range(length + 1);
+	const auto removed = random.range((length - offset < 16 ? length - offset : 16) + 1);
+	return { offset, removed, INSERTS[random.range(countof(INSERTS))] };
+}
+
+Bool bench_relex(System& sys) {
+	static constexpr const Ulen CHECKS = 2000;
+	static constexpr const Ulen EDITS = 200;
+
+	// Every check lexes the input again from scratch, the temporary allocator of
+	// the system would only free those at the very end.
+	SystemAllocator allocator{sys};
+
+	// Every edit must give the same tokens and comments as lexing the edited
+	// input from scratch.
+	{
+		auto lexer = Lexer::create(bench_corpus(allocator, 64 * 1024, 1));
+		if (!lexer) {
+			return false;
+		}
+		auto stream = lexer->tokenize_all(allocator);
+		if (!stream) {
+			return false;
+		}
+		BenchRandom random{0x72656c65}; // "rele"
+		for (Ulen i = 0; i < CHECKS; i++) {
+			const auto edit = random_edit(random, lexer->input());
+			if (!lexer->relex(*stream, edit)) {
+				return false;
+			}
+			auto fresh = copy_lexer(allocator, *lexer);
+			if (!fresh) {
+				return false;
+			}
+			auto expected = fresh->tokenize_all(allocator);
+			if (!expected || !same(*fresh, *expected, *lexer, *stream)) {
+				bench_report(sys, "relex.mismatch", Float64(i), "edit");
+				return false;
+			}
+		}
+	}
+
+	// Time edits of a large input against lexing all of it again.
+	const auto& options = bench_options();
+	auto lexer = Lexer::create(bench_corpus(allocator, options.size, 1));
+	if (!lexer) {
+		return false;
+	}
+	auto stream = lexer->tokenize_all(allocator);
+	if (!stream) {
+		return false;
+	}
+	const auto full = bench_best(sys, 3, [&] {
+		auto fresh = copy_lexer(allocator, *lexer);
+		if (fresh) {
+			bench_keep(fresh->tokenize_all(allocator).is_valid());
+		}
+	});
+	BenchRandom random{0x65646974}; // "edit"
+	Seconds edits{0.0};
+	for (Ulen i = 0; i < EDITS; i++) {
+		const auto edit = random_edit(random, lexer->input());
+		const auto beg = MonotonicTime::now(sys);
+		const auto relexed = lexer->relex(*stream, edit);
+		edits += MonotonicTime::now(sys) - beg;
+		if (!relexed) {
+			return false;
+		}
+	}
+	const auto edit = edits.value() / EDITS;
+	bench_report(sys, "relex.full", full.value() * 1e3, "ms");
+	bench_report(sys, "relex.edit", edit * 1e3, "ms");
+	bench_report(sys, "relex.speedup", full.value() / edit, "x");
+
+	return true;
+}
+
+} // namespace Thor
@@ -0,0 +1,248 @@
+#include <string.h> // strlen
+
+#include "util/system.h"
+#include "util/string.h"
+#include "util/file.h"
+
+#include "literal.h"
+#include "parser.h"
+
+#include "bench.h"
+
+namespace Thor {
+	extern const Filesystem STD_FILESYSTEM;
+	extern const Heap       STD_HEAP;
+	extern const Console    STD_CONSOLE;
+	extern const Process    STD_PROCESS;
+	extern const Linker     STD_LINKER;
+	extern const Scheduler  STD_SCHEDULER;
+	extern const Chrono     STD_CHRONO;
+
+	Bool bench_attributes(System& sys);
+	Bool bench_keywords(System& sys);
+	Bool bench_lazy(System& sys);
+	Bool bench_lexer(System& sys);
+	Bool bench_linearise(System& sys);
+	Bool bench_operators(System& sys);
+	Bool bench_relex(System& sys);
+	Bool bench_share(System& sys);
+	Bool bench_split(System& sys);
+	Bool bench_throughput(System& sys);
+	Bool bench_traverse(System& sys);
+	Bool bench_walk(System& sys);
+}
+
+using namespace Thor;
+
+// Results of an earlier run read from the -baseline file, which is the output of
+// -save: one "name: value unit" line per result.
+struct BenchBaseline {
+	StringView name;
+	Float64    value;
+};
+
+struct BenchState {
+	BenchState(Allocator& allocator)
+		: text{allocator}
+		, baseline{allocator}
+		, saved{allocator}
+	{
+	}
+	BenchOptions         options;
+	Array<Uint8>         text; // Contents of the baseline file
+	Array<BenchBaseline> baseline;
+	StringBuilder        saved;
+};
+
+static BenchState* s_state = nullptr;
+
+const BenchOptions& Thor::bench_options() {
+	return s_state->options;
+}
+
+void Thor::bench_report(System& sys, StringView name, Float64 value, StringView unit) {
+	ScratchAllocator<1024> scratch{sys.allocator};
+	StringBuilder builder{scratch};
+	builder.put(name);
+	builder.put(": ");
+	builder.put(value);
+	builder.put(' ');
+	builder.put(unit);
+	if (auto result = builder.result()) {
+		s_state->saved.put(*result);
+		s_state->saved.put('\n');
+	}
+	for (const auto& baseline : s_state->baseline) {
+		if (baseline.name == name && baseline.value != 0.0) {
+			builder.put(" (baseline ");
+			builder.put(baseline.value);
+			builder.put(", ");
+			const auto change = (value - baseline.value) / baseline.value * 100.0;
+			if (change >= 0.0) {
+				builder.put('+');
+			}
+			builder.put(change);
+			builder.put("%)");
+			break;
+		}
+	}
+	builder.put('\n');
+	if (auto result = builder.result()) {
+		sys.console.write(sys, *result);
+	}
+}
+
+Array<Uint8> Thor::bench_copy(Allocator& allocator, Slice<const Uint8> bytes) {
+	Array<Uint8> result{allocator};
+	if (result.resize(bytes.length())) {
+		for (Ulen i = 0; i < result.length(); i++) {
+			result[i] = bytes[i];
+		}
+	}
+	return result;
+}
+
+// Parse a size like 4096, 64K, 16M or 1G.
+static Maybe<Ulen> parse_size(StringView string) {
+	Ulen scale = 1;
+	if (!string.is_empty()) {
+		switch (string[string.length() - 1]) {
+		case 'K': case 'k': scale = 1024;               break;
+		case 'M': case 'm': scale = 1024 * 1024;        break;
+		case 'G': case 'g': scale = 1024 * 1024 * 1024; break;
+		}
+		if (scale != 1) {
+			string = string.truncate(string.length() - 1);
+		}
+	}
+	auto value = LiteralTable::decode_integer(string);
+	if (!value || *value == 0) {
+		return {};
+	}
+	return Ulen { *value * scale };
+}
+
+static Bool load_baseline(System& sys, BenchState& state) {
+	auto file = File::open(sys, state.options.baseline, File::Access::RD);
+	if (!file) {
+		return false;
+	}
+	state.text = file->map(sys.allocator);
+	const auto text = state.text.slice().cast<const char>();
+	for (Ulen beg = 0; beg < text.length(); /**/) {
+		auto end = beg;
+		while (end < text.length() && text[end] != '\n') end++;
+		const auto line = text.slice(beg).truncate(end - beg);
+		beg = end + 1;
+		// Split "name: value unit" at the ": " and the following ' '.
+		Ulen colon = 0;
+		while (colon + 1 < line.length() && !(line[colon] == ':' && line[colon + 1] == ' ')) colon++;
+		if (colon + 1 >= line.length()) {
+			continue;
+		}
+		const auto rest = line.slice(colon + 2);
+		Ulen space = 0;
+		while (space < rest.length() && rest[space] != ' ') space++;
+		const auto value = LiteralTable::decode_float(rest.truncate(space));
+		if (value && !state.baseline.push_back({ line.truncate(colon), *value })) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static Bool save_results(System& sys, const BenchState& state) {
+	auto file = File::open(sys, state.options.save, File::Access::WR);
+	if (!file) {
+		return false;
+	}
+	const auto result = state.saved.result();
+	return result && file->write(0, result->cast<const Uint8>()) == result->length();
+}
+
+static constexpr const struct {
+	StringView name;
+	Bool (*run)(System& sys);
+} BENCHES[] = {
+	{ "attributes", bench_attributes },
+	{ "keywords",   bench_keywords   },
+	{ "lazy",       bench_lazy       },
+	{ "lexer",      bench_lexer      },
+	{ "linearise",  bench_linearise  },
+	{ "operators",  bench_operators  },
+	{ "relex",      bench_relex      },
+	{ "share",      bench_share      },
+	{ "split",      bench_split      },
+	{ "throughput", bench_throughput },
+	{ "traverse",   bench_traverse   },
+	{ "walk",       bench_walk       },
+};
+
+int main(int argc, char **argv) {
+	System sys {
+		STD_FILESYSTEM,
+		STD_HEAP,
+		STD_CONSOLE,
+		STD_PROCESS,
+		STD_LINKER,
+		STD_SCHEDULER,
+		STD_CHRONO,
+	};
+
+	BenchState state{sys.allocator};
+	s_state = &state;
+
+	// Options are of the form -name=value, everything else is the name of a
+	// benchmark to run.
+	Ulen selections = 0;
+	for (int i = 1; i < argc; i++) {
+		const StringView arg { argv[i], strlen(argv[i]) };
+		if (arg.is_empty() || arg[0] != '-') {
+			selections++;
+			continue;
+		}
+		Ulen equals = 0;
+		while (equals < arg.length() && arg[equals] != '=') equals++;
+		const auto name = arg.slice(1).truncate(equals - 1);
+		const auto value = arg.slice(equals < arg.length() ? equals + 1 : equals);
+		if (name == "size" && parse_size(value)) {
+			state.options.size = *parse_size(value);
+		} else if (name == "threads" && parse_size(value)) {
+			state.options.threads = *parse_size(value);
+		} else if (name == "save" && !value.is_empty()) {
+			state.options.save = value;
+		} else if (name == "baseline" && !value.is_empty()) {
+			state.options.baseline = value;
+		} else {
+			sys.console.write(sys, StringView { "Unknown option, expected -size=, -threads=, -save= or -baseline=\n" });
+			return 1;
+		}
+	}
+	if (!state.options.baseline.is_empty() && !load_baseline(sys, state)) {
+		sys.console.write(sys, StringView { "Could not read the baseline\n" });
+		return 1;
+	}
+
+	// Run every benchmark, or just the ones named on the command line.
+	Bool ok = true;
+	for (const auto& bench : BENCHES) {
+		Bool selected = selections == 0;
+		for (int i = 1; i < argc; i++) {
+			if (bench.name == StringView { argv[i], strlen(argv[i]) }) {
+				selected = true;
+			}
+		}
+		if (selected && !bench.run(sys)) {
+			ok = false;
+		}
+	}
+
+	// Only when built with STATS=1 or STATS=2.
+	Parser::dump_stats(sys);
+
+	if (!state.options.save.is_empty() && !save_results(sys, state)) {
+		sys.console.write(sys, StringView { "Could not save the results\n" });
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+#include "util/system.h"
+
+#include "lexer.h"
+
+#include "bench.h"
+
+namespace Thor {
+
+// The nest of switch statements the lexer used to scan punctuation before it
+// walked a DFA, kept here as the reference to test and time the DFA against.
+// The mistakes it had, like '*=' and '==' not consuming their '=' and '<='
+// giving LT, are fixed so the two are expected to agree everywhere.
+static Token switch_punctuation(StringView input, Uint32 beg) {
+	const auto at = [&](Uint32 i) { return input[beg + i]; };
+	switch (at(0)) {
+	case '@': return { TokenKind::ATTRIBUTE,    beg, 1_u16 };
+	case '#': return { TokenKind::DIRECTIVE,    beg, 1_u16 };
+	case '$': return { TokenKind::CONST,        beg, 1_u16 };
+	case ';': return { TokenKind::EXPLICITSEMI, beg, 1_u16 };
+	case ',': return { TokenKind::COMMA,        beg, 1_u16 };
+	case '{': return { TokenKind::LBRACE,       beg, 1_u16 };
+	case '}': return { TokenKind::RBRACE,       beg, 1_u16 };
+	case '(': return { OperatorKind::LPAREN,    beg, 1_u16 };
+	case ')': return { OperatorKind::RPAREN,    beg, 1_u16 };
+	case '[': return { OperatorKind::LBRACKET,  beg, 1_u16 };
+	case ']': return { OperatorKind::RBRACKET,  beg, 1_u16 };
+	case '?': return { OperatorKind::QUESTION,  beg, 1_u16 };
+	case ':': return { OperatorKind::COLON,     beg, 1_u16 };
+	case '^': return { OperatorKind::POINTER,   beg, 1_u16 };
+	case '%':
+		switch (at(1)) {
+		case '=': return { AssignKind::MOD, beg, 2_u16 };
+		case '%':
+			if (at(2) == '=') return { AssignKind::REM, beg, 3_u16 };
+			return { OperatorKind::REM, beg, 2_u16 };
+		}
+		return { OperatorKind::MOD, beg, 1_u16 };
+	case '*':
+		if (at(1) == '=') return { AssignKind::MUL, beg, 2_u16 };
+		return { OperatorKind::MUL, beg, 1_u16 };
+	case '/':
+		if (at(1) == '=') return { AssignKind::QUO, beg, 2_u16 };
+		return { OperatorKind::QUO, beg, 1_u16 };
+	case '~':
+		if (at(1) == '=') return { AssignKind::XOR, beg, 2_u16 };
+		return { OperatorKind::XOR, beg, 1_u16 };
+	case '!':
+		if (at(1) == '=') return { OperatorKind::NEQ, beg, 2_u16 };
+		return { OperatorKind::LNOT, beg, 1_u16 };
+	case '+':
+		if (at(1) == '=') return { AssignKind::ADD, beg, 2_u16 };
+		return { OperatorKind::ADD, beg, 1_u16 };
+	case '-':
+		switch (at(1)) {
+		case '=': return { AssignKind::SUB, beg, 2_u16 };
+		case '>': return { OperatorKind::ARROW, beg, 2_u16 };
+		case '-':
+			if (at(2) == '-') return { TokenKind::UNDEFINED, beg, 3_u16 };
+		}
+		return { OperatorKind::SUB, beg, 1_u16 };
+	case '=':
+		if (at(1) == '=') return { OperatorKind::EQ, beg, 2_u16 };
+		return { AssignKind::EQ, beg, 1_u16 };
+	case '.':
+		if (at(1) == '.') {
+			switch (at(2)) {
+			case '<': return { OperatorKind::RANGEHALF, beg, 3_u16 };
+			case '=': return { OperatorKind::RANGEFULL, beg, 3_u16 };
+			}
+			return { OperatorKind::ELLIPSIS, beg, 2_u16 };
+		}
+		return { OperatorKind::PERIOD, beg, 1_u16 };
+	case '<':
+		switch (at(1)) {
+		case '=': return { OperatorKind::LTEQ, beg, 2_u16 };
+		case '<':
+			if (at(2) == '=') return { AssignKind::SHL, beg, 3_u16 };
+			return { OperatorKind::SHL, beg, 2_u16 };
+		}
+		return { OperatorKind::LT, beg, 1_u16 };
+	case '>':
+		switch (at(1)) {
+		case '=': return { OperatorKind::GTEQ, beg, 2_u16 };
+		case '>':
+			if (at(2) == '=') return { AssignKind::SHR, beg, 3_u16 };
+			return { OperatorKind::SHR, beg, 2_u16 };
+		}
+		return { OperatorKind::GT, beg, 1_u16 };
+	case '&':
+		switch (at(1)) {
+		case '~':
+			if (at(2) == '=') return { AssignKind::ANDNOT, beg, 3_u16 };
+			return { OperatorKind::ANDNOT, beg, 2_u16 };
+		case '=': return { AssignKind::BAND, beg, 2_u16 };
+		case '&':
+			if (at(2) == '=') return { AssignKind::LAND, beg, 3_u16 };
+			return { OperatorKind::LAND, beg, 2_u16 };
+		}
+		return { OperatorKind::BAND, beg, 1_u16 };
+	case '|':
+		switch (at(1)) {
+		case '=': return { AssignKind::BOR, beg, 2_u16 };
+		case '|':
+			if (at(2) == '=') return { AssignKind::LOR, beg, 3_u16 };
+			return { OperatorKind::LOR, beg, 2_u16 };
+		}
+		return { OperatorKind::BOR, beg, 1_u16 };
+	}
+	return { TokenKind::INVALID, beg, 0_u16 };
+}
+
+// Generate dense runs of punctuation with the occasional space or letter to
+// break them up, so every prefix of every operator turns up next to every other.
+static Array<Uint8> generate(System& sys, Ulen size) {
+	static constexpr const char CHARS[] = "@#$;,{}()[]?:^%*/~!+-=.<>&| a";
+	Array<Uint8> source{sys.allocator};
+	BenchRandom random{0x6f706572}; // "oper"
+	while (source.length() < size) {
+		if (!source.push_back(CHARS[random.range(countof(CHARS) - 1)])) {
+			return {sys.allocator};
+		}
+	}
+	return source;
+}
+
+// Whether [lhs] and [rhs] are the same token. Punctuation only carries a
+// sub-kind for assignments and operators, a bare '@' or '#' has none, so only
+// those are compared rather than a byte which means nothing for the others.
+static Bool same_punctuation(Token lhs, Token rhs) {
+	if (lhs.kind != rhs.kind || lhs.offset != rhs.offset || lhs.length != rhs.length) {
+		return false;
+	}
+	switch (lhs.kind) {
+	case TokenKind::ASSIGNMENT: return lhs.as_assign == rhs.as_assign;
+	case TokenKind::OPERATOR:   return lhs.as_operator == rhs.as_operator;
+	default:
+		return true;
+	}
+}
+
+Bool bench_operators(System& sys) {
+	static constexpr const Ulen SIZE = 16 * 1024 * 1024;
+	static constexpr const Ulen RUNS = 5;
+
+	auto lexer = Lexer::create(generate(sys, SIZE));
+	if (!lexer) {
+		return false;
+	}
+	const auto input = lexer->input();
+
+	// Differential test: both scanners must give the same token at every offset,
+	// not just at the offsets the lexer would start a token at.
+	Ulen mismatches = 0;
+	for (Uint32 offset = 0; offset < input.length(); offset++) {
+		const auto expected = switch_punctuation(input, offset);
+		const auto actual = Lexer::punctuation(input, offset);
+		if (!same_punctuation(expected, actual)) {
+			mismatches++;
+		}
+	}
+	if (mismatches != 0) {
+		bench_report(sys, "operators.mismatch", Float64(mismatches), "offsets");
+		return false;
+	}
+
+	auto scan = [&](auto&& fn) {
+		Uint64 sum = 0;
+		for (Uint32 offset = 0; offset < input.length(); /**/) {
+			const auto token = fn(input, offset);
+			sum += Uint64(token.kind) + Uint64(token.length);
+			offset += token.length ? token.length : 1;
+		}
+		bench_keep(sum);
+	};
+	const auto n = Float64(input.length());
+	const auto switched = bench_best(sys, RUNS, [&] { scan(switch_punctuation); });
+	const auto table = bench_best(sys, RUNS, [&] { scan(Lexer::punctuation); });
+	bench_report(sys, "operators.switch", n / switched.value() / (1024.0 * 1024.0), "MiB/s");
+	bench_report(sys, "operators.table", n / table.value() / (1024.0 * 1024.0), "MiB/s");
+	bench_report(sys, "operators.speedup", switched.value() / table.value(), "x");
+
+	return true;
+}
+
+} // namespace Thor
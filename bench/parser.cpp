@@ -0,0 +1,291 @@
+#include "util/system.h"
+
+#include "parser.h"
+
+#include "bench.h"
+
+namespace Thor {
+
+// Parse every statement of [parser] and dump them the way thor does. The result
+// is missing on a parse error, the dump of an unforced body would be invalid so
+// that is done by [force] beforehand.
+template<typename F>
+static Maybe<StringView> parse_and_dump(Parser& parser, Allocator& allocator, StringBuilder& builder, F&& force) {
+	Array<AstRef<AstStmt>> stmts{allocator};
+	for (;;) {
+		auto stmt = parser.parse_stmt(false, {}, {});
+		if (!stmt) {
+			break;
+		}
+		if (!stmts.push_back(move(stmt))) {
+			return {};
+		}
+	}
+	if (!parser.is_done() || !force()) {
+		return {};
+	}
+	const auto& ast = parser.ast();
+	for (auto stmt : stmts) {
+		if (ast[stmt].is_stmt<AstEmptyStmt>()) {
+			continue;
+		}
+		ast[stmt].dump(ast, builder, 0);
+		builder.put('\n');
+	}
+	return builder.result();
+}
+
+// Parse a file of declarations carrying attributes and directives and check that
+// every declaration kept them: both lists live in temporary memory until the
+// statement they belong to is made, so reusing that memory too early shows up
+// here as the wrong fields.
+Bool bench_attributes(System& sys) {
+	static constexpr const Ulen RUNS = 3;
+
+	static constexpr const StringView STMTS[] = {
+		"@(private) foo :: proc() {}\n",
+		"@(link_name=\"bar\", require) baz, qux := 1, 2\n",
+		"#no_bounds_check #force_inline quux := 3\n",
+	};
+	static constexpr const StringView EXPECTED[] = {
+		"@private",
+		"@link_name=\"bar\", require",
+		"#no_bounds_check, #force_inline",
+	};
+	static constexpr const Ulen COUNT = sizeof STMTS / sizeof *STMTS;
+
+	const auto& options = bench_options();
+	auto source = [&](Allocator& allocator) {
+		StringBuilder builder{allocator};
+		for (Ulen i = 0, length = 0; length < options.size / 16; i++) {
+			builder.put(STMTS[i % COUNT]);
+			length += STMTS[i % COUNT].length();
+		}
+		auto result = builder.result();
+		return bench_copy(allocator, result ? result->cast<const Uint8>() : Slice<const Uint8>{});
+	};
+
+	SourceManager sources{sys};
+	Diagnostics diagnostics{sys, sources};
+	auto check_sys = sys.clone();
+	auto check = Parser::create(check_sys, sources, diagnostics, "attributes.odin", source(check_sys.allocator));
+	if (!check) {
+		return false;
+	}
+	auto stmts = check->parse_all(1);
+	if (!stmts || !check->is_done()) {
+		return false;
+	}
+	const auto& ast = check->ast();
+	Ulen decls = 0;
+	for (auto stmt : *stmts) {
+		auto decl = ast[stmt].to_stmt<AstDeclStmt>();
+		if (!decl) {
+			continue;
+		}
+		StringBuilder builder{check_sys.allocator};
+		Bool first = true;
+		for (auto attribute : ast[decl->attributes]) {
+			builder.put(first ? StringView { "@" } : StringView { ", " });
+			ast[attribute].dump(ast, builder);
+			first = false;
+		}
+		for (auto directive : ast[decl->directives]) {
+			if (!first) {
+				builder.put(StringView { ", " });
+			}
+			ast[directive].dump(ast, builder);
+			first = false;
+		}
+		auto actual = builder.result();
+		if (!actual || !(*actual == EXPECTED[decls % COUNT])) {
+			bench_report(sys, "attributes.mismatch", Float64(decls), "decls");
+			return false;
+		}
+		decls++;
+	}
+
+	// Making the parser lexes the file, which is left out of the time.
+	Seconds best{0.0};
+	for (Ulen run = 0; run < RUNS; run++) {
+		auto parse_sys = sys.clone();
+		auto parser = Parser::create(parse_sys, sources, diagnostics, "attributes.odin", source(parse_sys.allocator));
+		if (!parser) {
+			return false;
+		}
+		const auto beg = MonotonicTime::now(sys);
+		auto parsed = parser->parse_all(1);
+		const auto elapsed = MonotonicTime::now(sys) - beg;
+		if (!parsed || !parser->is_done()) {
+			return false;
+		}
+		if (run == 0 || elapsed.value() < best.value()) {
+			best = elapsed;
+		}
+	}
+	bench_report(sys, "attributes.decls", Float64(decls), "decls");
+	bench_report(sys, "attributes.parse", best.value() * 1e3, "ms");
+
+	return true;
+}
+
+Bool bench_lazy(System& sys) {
+	static constexpr const Ulen RUNS = 3;
+
+	const auto& options = bench_options();
+	const auto corpus = bench_corpus(sys.allocator, options.size, 1);
+	if (corpus.is_empty()) {
+		return false;
+	}
+
+	// Forcing every deferred body must give the same AST as parsing eagerly.
+	SourceManager sources{sys};
+	Diagnostics diagnostics{sys, sources};
+	auto eager_sys = sys.clone();
+	auto eager = Parser::create(eager_sys, sources, diagnostics, "corpus.odin", bench_copy(eager_sys.allocator, corpus.slice()));
+	auto lazy_sys = sys.clone();
+	auto lazy = Parser::create(lazy_sys, sources, diagnostics, "corpus.odin", bench_copy(lazy_sys.allocator, corpus.slice()));
+	if (!eager || !lazy) {
+		return false;
+	}
+	lazy->defer_bodies();
+	StringBuilder eager_dump{eager_sys.allocator};
+	StringBuilder lazy_dump{lazy_sys.allocator};
+	auto expected = parse_and_dump(*eager, eager_sys.allocator, eager_dump, [] { return true; });
+	auto actual = parse_and_dump(*lazy, lazy_sys.allocator, lazy_dump, [&] { return lazy->force_bodies(); });
+	if (!expected || !actual || !(*expected == *actual)) {
+		bench_report(sys, "lazy.mismatch", 0.0, "bodies");
+		return false;
+	}
+	const auto bodies = lazy->deferred();
+
+	// Time parsing every statement eagerly, with the bodies deferred, and the
+	// forcing of those bodies. Making the parser lexes the file, which is left
+	// out of every time.
+	Seconds times[3] = { Seconds{0.0}, Seconds{0.0}, Seconds{0.0} };
+	for (Ulen run = 0; run < RUNS; run++) {
+		for (Ulen mode = 0; mode < 2; mode++) {
+			auto parse_sys = sys.clone();
+			auto parser = Parser::create(parse_sys, sources, diagnostics, "corpus.odin", bench_copy(parse_sys.allocator, corpus.slice()));
+			if (!parser) {
+				return false;
+			}
+			if (mode == 1) {
+				parser->defer_bodies();
+			}
+			const auto beg = MonotonicTime::now(sys);
+			while (parser->parse_stmt(false, {}, {})) {
+				// Nothing to do with the statement.
+			}
+			const auto parsed = MonotonicTime::now(sys);
+			const auto forced = mode == 1 && parser->force_bodies();
+			const auto end = MonotonicTime::now(sys);
+			if (!parser->is_done() || (mode == 1 && !forced)) {
+				return false;
+			}
+			const Seconds elapsed[] = { parsed - beg, end - parsed };
+			for (Ulen i = 0; i <= mode; i++) {
+				auto& time = times[mode + i];
+				if (run == 0 || elapsed[i].value() < time.value()) {
+					time = elapsed[i];
+				}
+			}
+		}
+	}
+	bench_report(sys, "lazy.bodies", Float64(bodies), "bodies");
+	bench_report(sys, "lazy.eager", times[0].value() * 1e3, "ms");
+	bench_report(sys, "lazy.deferred", times[1].value() * 1e3, "ms");
+	bench_report(sys, "lazy.forced", times[2].value() * 1e3, "ms");
+	bench_report(sys, "lazy.speedup", times[0].value() / times[1].value(), "x");
+
+	return true;
+}
+
+Bool bench_split(System& sys) {
+	static constexpr const Ulen RUNS = 3;
+
+	const auto& options = bench_options();
+	const auto corpus = bench_corpus(sys.allocator, options.size, 1);
+	if (corpus.is_empty()) {
+		return false;
+	}
+
+	auto dump = [](const AstFile& ast, Slice<AstRef<AstStmt>> stmts, StringBuilder& builder) {
+		for (auto stmt : stmts) {
+			if (ast[stmt].is_stmt<AstEmptyStmt>()) {
+				continue;
+			}
+			ast[stmt].dump(ast, builder, 0);
+			builder.put('\n');
+		}
+		return builder.result();
+	};
+
+	// Parsing the pieces of the file on any number of threads and merging them
+	// must give the same AST as parsing it on one.
+	SourceManager sources{sys};
+	Diagnostics diagnostics{sys, sources};
+	auto one_sys = sys.clone();
+	auto one = Parser::create(one_sys, sources, diagnostics, "corpus.odin", bench_copy(one_sys.allocator, corpus.slice()));
+	if (!one) {
+		return false;
+	}
+	auto one_stmts = one->parse_all(1);
+	StringBuilder one_dump{one_sys.allocator};
+	auto expected = one_stmts && one->is_done() ? dump(one->ast(), one_stmts->slice(), one_dump) : Maybe<StringView>{};
+	if (!expected) {
+		return false;
+	}
+
+	Seconds single{0.0};
+	Seconds most{0.0};
+	for (Ulen threads = 1; threads <= options.threads; threads *= 2) {
+		auto many_sys = sys.clone();
+		auto many = Parser::create(many_sys, sources, diagnostics, "corpus.odin", bench_copy(many_sys.allocator, corpus.slice()));
+		if (!many) {
+			return false;
+		}
+		auto many_stmts = many->parse_all(threads);
+		StringBuilder many_dump{many_sys.allocator};
+		auto actual = many_stmts && many->is_done() ? dump(many->ast(), many_stmts->slice(), many_dump) : Maybe<StringView>{};
+		if (!actual || !(*expected == *actual)) {
+			bench_report(sys, "split.mismatch", Float64(threads), "threads");
+			return false;
+		}
+
+		// Making the parser lexes the file, which is left out of the time.
+		Seconds best{0.0};
+		for (Ulen run = 0; run < RUNS; run++) {
+			auto parse_sys = sys.clone();
+			auto parser = Parser::create(parse_sys, sources, diagnostics, "corpus.odin", bench_copy(parse_sys.allocator, corpus.slice()));
+			if (!parser) {
+				return false;
+			}
+			const auto beg = MonotonicTime::now(sys);
+			auto stmts = parser->parse_all(threads);
+			const auto elapsed = MonotonicTime::now(sys) - beg;
+			if (!stmts || !parser->is_done()) {
+				return false;
+			}
+			if (run == 0 || elapsed.value() < best.value()) {
+				best = elapsed;
+			}
+		}
+		if (threads == 1) {
+			single = best;
+		}
+		most = best;
+		ScratchAllocator<64> scratch{sys.allocator};
+		StringBuilder name{scratch};
+		name.put("split.threads");
+		name.put(Uint64(threads));
+		if (auto result = name.result()) {
+			bench_report(sys, *result, best.value() * 1e3, "ms");
+		}
+	}
+	bench_report(sys, "split.speedup", single.value() / most.value(), "x");
+
+	return true;
+}
+
+} // namespace Thor
@@ -0,0 +1,261 @@
+#include "util/system.h"
+#include "util/thread.h"
+
+#include "parser.h"
+
+#include "bench.h"
+
+namespace Thor {
+
+// Every worker thread has a System of its own as the allocator of a System is
+// not thread safe. Everything a worker makes is allocated from it.
+struct ThroughputWorker {
+	ThroughputWorker(const System& sys)
+		: sys{sys.clone()}
+	{
+	}
+	System sys;
+};
+
+// Run [fn] for every one of [files], file N on worker N modulo the number of
+// workers, and time how long it takes for all of them to finish. The result is
+// missing when [fn] fails for any file.
+template<typename F>
+static Maybe<Seconds> parallel(System& sys, Slice<ThroughputWorker*> workers, Ulen files, F&& fn) {
+	struct Task {
+		F*                fn;
+		ThroughputWorker* worker;
+		Ulen              beg;
+		Ulen              step;
+		Ulen              end;
+		Bool              ok;
+		static void run(System&, void* user) {
+			auto& task = *static_cast<Task*>(user);
+			for (auto i = task.beg; i < task.end; i += task.step) {
+				task.ok = task.ok && (*task.fn)(*task.worker, i);
+			}
+		}
+	};
+	Array<Task> tasks{sys.allocator};
+	for (Ulen i = 0; i < workers.length(); i++) {
+		if (!tasks.push_back({ &fn, workers[i], i, workers.length(), files, true })) {
+			return {};
+		}
+	}
+	Array<Thread> threads{sys.allocator};
+	if (!threads.reserve(tasks.length())) {
+		return {};
+	}
+	const auto beg = MonotonicTime::now(sys);
+	for (Ulen i = 1; i < tasks.length(); i++) {
+		auto& task = tasks[i];
+		auto thread = Thread::start(task.worker->sys, Task::run, &task);
+		if (!thread || !threads.push_back(move(*thread))) {
+			Task::run(task.worker->sys, &task);
+		}
+	}
+	Task::run(tasks[0].worker->sys, &tasks[0]);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	auto elapsed = MonotonicTime::now(sys) - beg;
+	for (const auto& task : tasks) {
+		if (!task.ok) {
+			return {};
+		}
+	}
+	return elapsed;
+}
+
+Bool bench_throughput(System& sys) {
+	static constexpr const Ulen RUNS = 3;
+	// The corpus is split into files like a package would be. This many files
+	// divides evenly between any power of two threads up to it.
+	static constexpr const Ulen FILES = 64;
+
+	const auto& options = bench_options();
+
+	// Generate the corpus as one buffer with the offset of each file in it.
+	Array<Uint8> corpus{sys.allocator};
+	Array<Ulen> bounds{sys.allocator};
+	if (!bounds.push_back(0)) {
+		return false;
+	}
+	for (Ulen i = 0; i < FILES; i++) {
+		const auto file = bench_corpus(sys.allocator, options.size / FILES, i + 1);
+		if (file.is_empty()) {
+			return false;
+		}
+		for (auto byte : file) {
+			if (!corpus.push_back(byte)) return false;
+		}
+		if (!bounds.push_back(corpus.length())) {
+			return false;
+		}
+	}
+	const auto size = Float64(corpus.length()) / (1024.0 * 1024.0 * 1024.0);
+
+	// A copy of file [i] of the corpus made with [allocator].
+	auto copy = [&](Allocator& allocator, Ulen i) {
+		return bench_copy(allocator, corpus.slice().slice(bounds[i]).truncate(bounds[i + 1] - bounds[i]).cast<const Uint8>());
+	};
+
+	auto report = [&](StringView stage, Ulen threads, Seconds time, Ulen tokens) {
+		ScratchAllocator<256> scratch{sys.allocator};
+		StringBuilder name{scratch};
+		name.put("throughput.");
+		name.put(stage);
+		name.put('.');
+		name.put(Uint64(threads));
+		if (auto result = name.result()) {
+			bench_report(sys, *result, size / time.value(), "GiB/s");
+		}
+		name.put(".tokens");
+		if (auto result = name.result()) {
+			bench_report(sys, *result, Float64(tokens) / time.value() / 1e6, "Mtokens/s");
+		}
+	};
+
+	// The first run is on a single thread, that gets all of the AST slab IDs
+	// assigned before any threads race to do it.
+	Array<Ulen> thread_counts{sys.allocator};
+	for (Ulen threads = 1; threads < options.threads; threads *= 2) {
+		if (!thread_counts.push_back(threads)) return false;
+	}
+	if (!thread_counts.push_back(options.threads)) {
+		return false;
+	}
+
+	for (const auto threads : thread_counts) {
+		Array<ThroughputWorker*> workers{sys.allocator};
+		auto destroy = [&] {
+			for (auto worker : workers) {
+				sys.allocator.destroy(worker);
+			}
+		};
+		for (Ulen i = 0; i < threads; i++) {
+			auto worker = sys.allocator.create<ThroughputWorker>(sys);
+			if (!worker || !workers.push_back(worker)) {
+				sys.allocator.destroy(worker);
+				destroy();
+				return false;
+			}
+		}
+
+		// Lexer::next over every file. The lexers are made beforehand, which pads
+		// a copy of the file, so only lexing is timed.
+		Array<Maybe<Lexer>> lexers{sys.allocator};
+		Array<Ulen> tokens{sys.allocator};
+		Maybe<Seconds> lex;
+		for (Ulen run = 0; run < RUNS; run++) {
+			lexers.clear();
+			tokens.clear();
+			for (Ulen i = 0; i < FILES; i++) {
+				if (!lexers.emplace_back() || !tokens.push_back(0)) {
+					destroy();
+					return false;
+				}
+			}
+			auto made = parallel(sys, workers.slice(), FILES, [&](ThroughputWorker& worker, Ulen i) {
+				lexers[i] = Lexer::create(copy(worker.sys.allocator, i));
+				return lexers[i].is_valid();
+			});
+			auto time = made ? parallel(sys, workers.slice(), FILES, [&](ThroughputWorker&, Ulen i) {
+				for (;;) {
+					tokens[i]++;
+					if (lexers[i]->next().kind == TokenKind::ENDOF) {
+						return true;
+					}
+				}
+			}) : Maybe<Seconds>{};
+			if (!time) {
+				destroy();
+				return false;
+			}
+			if (!lex || time->value() < lex->value()) {
+				lex = move(*time);
+			}
+		}
+		lexers.clear();
+		Ulen total = 0;
+		for (const auto n : tokens) {
+			total += n;
+		}
+		report("lex", threads, *lex, total);
+
+		// Parser::parse_stmt over every file, then the AST dump of the statements
+		// which were parsed. Making the parser lexes the file, which is left out.
+		SourceManager sources{sys};
+		Diagnostics diagnostics{sys, sources};
+		Array<Maybe<Parser>> parsers{sys.allocator};
+		Array<Maybe<Array<AstRef<AstStmt>>>> stmts{sys.allocator};
+		Maybe<Seconds> parse;
+		Maybe<Seconds> dump;
+		for (Ulen run = 0; run < RUNS; run++) {
+			stmts.clear();
+			parsers.clear();
+			for (Ulen i = 0; i < FILES; i++) {
+				if (!parsers.emplace_back() || !stmts.emplace_back()) {
+					destroy();
+					return false;
+				}
+			}
+			auto made = parallel(sys, workers.slice(), FILES, [&](ThroughputWorker& worker, Ulen i) {
+				parsers[i] = Parser::create(worker.sys, sources, diagnostics, "corpus.odin", copy(worker.sys.allocator, i));
+				stmts[i].emplace(worker.sys.allocator);
+				return parsers[i].is_valid();
+			});
+			auto parsed = made ? parallel(sys, workers.slice(), FILES, [&](ThroughputWorker&, Ulen i) {
+				for (;;) {
+					auto stmt = parsers[i]->parse_stmt(false, {}, {});
+					if (!stmt) {
+						// Stopping anywhere but the end is a parse error.
+						return parsers[i]->is_done();
+					}
+					if (!stmts[i]->push_back(move(stmt))) {
+						return false;
+					}
+				}
+			}) : Maybe<Seconds>{};
+			auto dumped = parsed ? parallel(sys, workers.slice(), FILES, [&](ThroughputWorker& worker, Ulen i) {
+				const auto& ast = parsers[i]->ast();
+				StringBuilder builder{worker.sys.allocator};
+				for (auto stmt : *stmts[i]) {
+					if (ast[stmt].is_stmt<AstEmptyStmt>()) {
+						continue;
+					}
+					ast[stmt].dump(ast, builder, 0);
+					builder.put('\n');
+				}
+				if (auto result = builder.result()) {
+					bench_keep(result->length());
+					return true;
+				}
+				return false;
+			}) : Maybe<Seconds>{};
+			if (!dumped) {
+				stmts.clear();
+				parsers.clear();
+				destroy();
+				bench_report(sys, "throughput.parse.failed", Float64(threads), "threads");
+				return false;
+			}
+			if (!parse || parsed->value() < parse->value()) {
+				parse = move(*parsed);
+			}
+			if (!dump || dumped->value() < dump->value()) {
+				dump = move(*dumped);
+			}
+		}
+		stmts.clear();
+		parsers.clear();
+		report("parse", threads, *parse, total);
+		report("dump", threads, *dump, total);
+
+		destroy();
+	}
+
+	return true;
+}
+
+} // namespace Thor
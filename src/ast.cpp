@@ -9,19 +9,103 @@
 
 namespace Thor {
 
+// Collects the nodes a node refers to, in the order of its fields.
+struct AstChildren {
+	template<typename T>
+	void operator()(AstRef<T> ref) {
+		if (ref) {
+			ok = ok && children.push_back(ref);
+		}
+	}
+	template<typename T>
+	void operator()(AstRefArray<T> refs) {
+		for (const auto ref : ast[refs]) {
+			(*this)(ref);
+		}
+	}
+	void operator()(AstStringRef) {
+	}
+	const AstFile&          ast;
+	Array<AstRef<AstNode>>& children;
+	Bool                    ok = true;
+};
+
+template<typename T>
+Bool AstSlabID::children_node(const AstFile& ast, void* node, Array<AstRef<AstNode>>& children) {
+	AstChildren collect{ast, children};
+	if constexpr (requires(T& t) { t.visit(collect); }) {
+		static_cast<T*>(node)->visit(collect);
+	}
+	return collect.ok;
+}
+
+// The map for AstTypeKey::make giving the references of a node of another file
+// as they are once it is merged.
+struct AstMerged {
+	AstID operator()(AstID id) {
+		return remap(id);
+	}
+	AstStringRef operator()(AstStringRef ref) {
+		remap(ref);
+		return ref;
+	}
+	AstRemap& remap;
+};
+
+template<typename T>
+Bool AstSlabID::key_node(const void* node, AstRemap* remap, AstTypeKey& key) {
+	// A copy as making the key takes the references of a node to change them.
+	T copy = *static_cast<const T*>(node);
+	if (!remap) {
+		AstTypeKey::Identity identity;
+		return AstTypeKey::make(copy, identity, key);
+	}
+	AstMerged merged{*remap};
+	return AstTypeKey::make(copy, merged, key);
+}
+
+template<typename... Ts>
+struct AstSlabID::Tables<AstTypeList<Ts...>> {
+	static inline constexpr const Remap REMAP[] = { remap_node<Ts>... };
+	static inline constexpr const Children CHILDREN[] = { children_node<Ts>... };
+	static inline constexpr const Key KEY[] = { key_node<Ts>... };
+	static inline constexpr const Ulen SIZE[] = { sizeof(Ts)... };
+};
+
+AstSlabID::Remap AstSlabID::remap(Uint32 id) {
+	using Table = Tables<AstNodeTypes>;
+	return id < AstNodeTypes::LENGTH ? Table::REMAP[id] : nullptr;
+}
+
+AstSlabID::Children AstSlabID::children(Uint32 id) {
+	using Table = Tables<AstNodeTypes>;
+	return id < AstNodeTypes::LENGTH ? Table::CHILDREN[id] : nullptr;
+}
+
+AstSlabID::Key AstSlabID::key(Uint32 id) {
+	using Table = Tables<AstNodeTypes>;
+	return id < AstNodeTypes::LENGTH ? Table::KEY[id] : nullptr;
+}
+
+Ulen AstSlabID::size(Uint32 id) {
+	using Table = Tables<AstNodeTypes>;
+	return id < AstNodeTypes::LENGTH ? Table::SIZE[id] : 0;
+}
+
 struct AstFileHeader {
 	Uint8  magic[4]; // tast
 	Uint32 version;
 	Uint64 slabs;
+	Uint64 capacity;
 };
 
-Maybe<AstFile> AstFile::create(System& sys, StringView filename) {
+Maybe<AstFile> AstFile::create(System& sys, StringView filename, Ulen capacity) {
 	StringTable table{sys.allocator};
 	auto ref = table.insert(filename);
 	if (!ref) {
 		return {};
 	}
-	return AstFile { sys, move(table), ref };
+	return AstFile { sys, move(table), ref, Uint32(capacity < NODES ? capacity : NODES) };
 }
 
 Maybe<AstFile> AstFile::load(System& sys, Stream& stream) {
@@ -32,7 +116,9 @@ Maybe<AstFile> AstFile::load(System& sys, Stream& stream) {
 	if (header.magic != Slice{"tast"}.cast<const Uint8>()) {
 		return {};
 	}
-	if (header.version != 1) {
+	// Version 3 keeps every node of a kind in one Region, version 4 adds how
+	// many nodes of each kind they have room for and version 5 the shared types.
+	if (header.version != 5 || header.capacity > NODES) {
 		return {};
 	}
 	auto string_table = StringTable::load(sys.allocator, stream);
@@ -44,50 +130,67 @@ Maybe<AstFile> AstFile::load(System& sys, Stream& stream) {
 	if (!stream.read(Slice{&filename, 1}.cast<Uint8>())) {
 		return {};
 	}
-	// Count the # of slabs indicated by the bitset.
-	Ulen n_slabs = 0;
+	AstFile result{sys, move(*string_table), filename, Uint32(header.capacity)};
+	// Read in a region for each kind indicated by the bitset.
 	for (Uint64 i = 0; i < 64; i++) {
-		if ((header.slabs & (1_u64 << Uint64(i))) != 0) {
-			n_slabs++;
+		if ((header.slabs & (1_u64 << i)) == 0) {
+			continue;
+		}
+		if (i >= AstNodeTypes::LENGTH) {
+			// ERROR: A kind of node this process does not know.
+			return {};
+		}
+		// The nodes are read in place so they must be those of this process.
+		if (auto region = Region::load(sys, stream, AstSlabID::size(i), result.capacity_)) {
+			result.regions_[i] = move(*region);
+		} else {
+			return {};
 		}
 	}
-	Array<Maybe<Slab>> slabs{sys.allocator};
-	if (!slabs.resize(n_slabs)) {
+	// Read the shared types in and make their keys again so types made after
+	// the load are shared with them.
+	Uint64 n_shared = 0;
+	if (!stream.read(Slice{&n_shared, 1}.cast<Uint8>())) {
 		return {};
 	}
-	for (Ulen i = 0; i < n_slabs; i++) {
-		if ((header.slabs & (1_u64 << Uint64(i))) != 0) {
-			if (!slabs[i]->load(sys.allocator, stream)) {
-				return {};
-			}
+	if (n_shared > Uint64(MAX) || !result.shared_.resize(Ulen(n_shared))) {
+		return {};
+	}
+	if (!stream.read(result.shared_.slice().cast<Uint8>())) {
+		return {};
+	}
+	for (const auto id : result.shared_) {
+		const auto kind = id.value_ >> SHIFT;
+		const auto index = id.value_ & (MAX - 1);
+		if (kind >= AstNodeTypes::LENGTH || !result.regions_[kind] || index >= result.regions_[kind]->length()) {
+			// ERROR: A shared type which is not in the file.
+			return {};
+		}
+		AstTypeKey key;
+		if (!AstSlabID::key(kind)(result.address<AstNode>(id), nullptr, key)) {
+			return {};
+		}
+		if (!result.types_.insert(key, id)) {
+			return {};
 		}
 	}
-	// Read in the IDs
-	Array<AstID> ids{sys.allocator};
 	// Read the AstID list in.
-	return AstFile {
-		sys,
-		move(*string_table),
-		filename,
-		move(slabs),
-		move(ids)
-	};
+	return result;
 }
 
 Bool AstFile::save(Stream& stream) const {
 	AstFileHeader header {
-		.magic   = { 't', 'a', 's', 't' },
-		.version = 1,
-		.slabs   = 0
+		.magic    = { 't', 'a', 's', 't' },
+		.version  = 5,
+		.slabs    = 0,
+		.capacity = capacity_,
 	};
-	// Determine which slabs are in-use. There is only 64 possible slab types
-	// due to a 6-bit AstSlabID. We can store the occupancy in one 64-bit word.
-	Ulen i = 0;
-	for (const auto& slab : slabs_) {
-		if (slab) {
+	// Determine which regions are in-use. There is only 64 possible kinds due
+	// to a 6-bit AstSlabID. We can store the occupancy in one 64-bit word.
+	for (Ulen i = 0; i < AstNodeTypes::LENGTH; i++) {
+		if (regions_[i]) {
 			header.slabs |= 1_u64 << Uint64(i);
 		}
-		i++;
 	}
 	auto src = Slice{&header, 1}.cast<const Uint8>();
 	if (!stream.write(src)) {
@@ -96,12 +199,17 @@ Bool AstFile::save(Stream& stream) const {
 	if (!string_table_.save(stream)) {
 		return false;
 	}
-	for (const auto& slab : slabs_) {
-		if (slab && !slab->save(stream)) {
+	if (!stream.write(Slice{&filename_, 1}.cast<const Uint8>())) {
+		return false;
+	}
+	for (const auto& region : regions_) {
+		if (region && !region->save(stream)) {
 			return false;
 		}
 	}
-	return true;
+	const Uint64 n_shared = shared_.length();
+	return stream.write(Slice{&n_shared, 1}.cast<const Uint8>())
+	    && stream.write(shared_.slice().cast<const Uint8>());
 }
 
 AstFile::~AstFile() {
@@ -117,6 +225,147 @@ AstIDArray AstFile::insert(Slice<const AstID> ids) {
 	return AstIDArray { Uint64(offset), Uint64(ids.length()) };
 }
 
+Maybe<AstRemap> AstFile::merge(const AstFile& other) {
+	AstRemap remap{*this, other};
+
+	// The nodes of [other] go after those here. A node can refer to nodes of any
+	// kind so where each kind goes is known before anything is renumbered.
+	for (Ulen i = 0; i < AstNodeTypes::LENGTH; i++) {
+		if (!remap.dropped_.emplace_back(sys_.allocator)) {
+			return {};
+		}
+		const auto& region = other.regions_[i];
+		if (!region) {
+			continue;
+		}
+		auto& into = regions_[i];
+		if (!into) {
+			if (auto made = Region::create(sys_, region->size(), capacity_)) {
+				into = move(*made);
+			} else {
+				unreserved_ = true;
+				return {};
+			}
+		}
+		if (!AstSlabID::remap(i)) {
+			// A kind this process never made nodes for.
+			return {};
+		}
+		remap.offsets_[i] = Uint32(into->length());
+	}
+
+	// Share the types shared in [other] with those here. A type is listed after
+	// the types it refers to so they have been looked up by the time its key is
+	// made. The types found here are not copied, which moves the nodes after
+	// them of the same kind down.
+	if (!shared_.reserve(shared_.length() + other.shared_.length())) {
+		return {};
+	}
+	Ulen dropped = 0;
+	for (const auto id : other.shared_) {
+		const auto kind = id.value_ >> SHIFT;
+		AstTypeKey key;
+		if (!AstSlabID::key(kind)(other.address<AstNode>(id), &remap, key)) {
+			continue;
+		}
+		if (auto found = types_.find(key)) {
+			if (!remap.types_.insert(id.value_, found->v)) {
+				return {};
+			}
+			if (!remap.dropped_[kind].push_back(id.value_ & (MAX - 1))) {
+				return {};
+			}
+			remap.kinds_ |= 1_u64 << kind;
+			dropped++;
+		} else if (!types_.insert(key, remap(id)) || !shared_.push_back(remap(id))) {
+			return {};
+		}
+	}
+
+	for (Ulen i = 0; i < AstNodeTypes::LENGTH; i++) {
+		const auto& region = other.regions_[i];
+		const auto& skip = remap.dropped_[i];
+		if (region && !regions_[i]->append(*region, skip.slice())) {
+			// Out of memory or IDs
+			return {};
+		}
+	}
+
+	remap.ids_ = ids_.length();
+	if (!ids_.reserve(ids_.length() + other.ids_.length())) {
+		return {};
+	}
+	for (const auto id : other.ids_) {
+		if (!ids_.push_back(remap(id))) {
+			return {};
+		}
+	}
+
+	for (Ulen i = 0; i < AstNodeTypes::LENGTH; i++) {
+		if (!other.regions_[i]) {
+			continue;
+		}
+		const auto fn = AstSlabID::remap(i);
+		regions_[i]->each(remap.offsets_[i], [&](Uint8* node) {
+			fn(node, remap);
+		});
+	}
+	if (!remap.ok_) {
+		// Out of memory for strings
+		return {};
+	}
+	nodes_ += other.nodes_ - dropped;
+	return remap;
+}
+
+Maybe<AstLinear> AstFile::linearise(Slice<const AstRef<AstStmt>> roots) const {
+	// A node still to be listed and the index of its parent. The stack is used
+	// rather than recursion as expressions can nest very deeply.
+	struct Visit {
+		AstID  id;
+		Uint32 parent;
+	};
+	Array<AstLinear::Node> nodes{sys_.allocator};
+	Array<Visit> stack{sys_.allocator};
+	Array<AstRef<AstNode>> children{sys_.allocator};
+	if (!nodes.reserve(nodes_)) {
+		return {};
+	}
+	for (Ulen i = roots.length(); i-- > 0; /**/) {
+		if (roots[i] && !stack.push_back({ roots[i].id_, AstLinear::NONE })) {
+			return {};
+		}
+	}
+	while (!stack.is_empty()) {
+		const auto visit = stack.last();
+		stack.pop_back();
+		const auto index = Uint32(nodes.length());
+		const auto kind = visit.id.value_ >> SHIFT;
+		if (!nodes.push_back({ visit.id, kind, 1, visit.parent })) {
+			return {};
+		}
+		children.clear();
+		if (!AstSlabID::children(kind)(*this, address<AstNode>(visit.id), children)) {
+			return {};
+		}
+		// Pushed last to first so that the first child is listed next.
+		for (Ulen i = children.length(); i-- > 0; /**/) {
+			if (!stack.push_back({ children[i].id_, index })) {
+				return {};
+			}
+		}
+	}
+	// Every node is listed after its parent, so going backwards the size of a
+	// node is complete by the time it is added to that of its parent.
+	for (Ulen i = nodes.length(); i-- > 0; /**/) {
+		const auto& node = nodes[i];
+		if (node.parent != AstLinear::NONE) {
+			nodes[node.parent].size += node.size;
+		}
+	}
+	return AstLinear { move(nodes) };
+}
+
 // Stmt
 void AstStmt::dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const {
 	using enum Kind;
@@ -613,8 +862,28 @@ void AstFloatExpr::dump(const AstFile&, StringBuilder& builder) const {
 }
 
 void AstStringExpr::dump(const AstFile& ast, StringBuilder& builder) const {
+	// The value has had its escape sequences decoded, escape it again so the dump
+	// reads back as the same string.
+	static constexpr const char HEX[] = "0123456789abcdef";
 	builder.put('"');
-	builder.put(ast[value]);
+	for (const auto ch : ast[value]) {
+		switch (ch) {
+		case '"':  builder.put("\\\""); break;
+		case '\\': builder.put("\\\\"); break;
+		case '\n': builder.put("\\n"); break;
+		case '\r': builder.put("\\r"); break;
+		case '\t': builder.put("\\t"); break;
+		default:
+			if (Uint8(ch) < 0x20 || ch == 0x7f) {
+				builder.put("\\x");
+				builder.put(HEX[Uint8(ch) >> 4]);
+				builder.put(HEX[Uint8(ch) & 0xf]);
+			} else {
+				builder.put(ch);
+			}
+			break;
+		}
+	}
 	builder.put('"');
 }
 
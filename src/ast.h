@@ -1,6 +1,9 @@
 #ifndef THOR_AST_H
 #define THOR_AST_H
-#include "util/slab.h"
+#include "util/region.h"
+#include "util/array.h"
+#include "util/map.h"
+#include "util/traits.h"
 #include "util/string.h"
 #include "util/assert.h"
 #include "util/system.h"
@@ -14,11 +17,74 @@ struct AstStmt;
 struct AstType;
 struct AstField;
 struct AstDirective;
-
-struct AstFile;
+struct AstBinExpr;
+struct AstUnaryExpr;
+struct AstIfExpr;
+struct AstWhenExpr;
+struct AstForInExpr;
+struct AstDerefExpr;
+struct AstOrReturnExpr;
+struct AstOrBreakExpr;
+struct AstOrContinueExpr;
+struct AstCallExpr;
+struct AstIdentExpr;
+struct AstUndefExpr;
+struct AstContextExpr;
+struct AstProcExpr;
+struct AstSliceExpr;
+struct AstIndexExpr;
+struct AstIntExpr;
+struct AstFloatExpr;
+struct AstStringExpr;
+struct AstImaginaryExpr;
+struct AstCompoundExpr;
+struct AstCastExpr;
+struct AstSelectorExpr;
+struct AstAccessExpr;
+struct AstAssertExpr;
+struct AstTypeExpr;
+struct AstTypeIDType;
+struct AstUnionType;
+struct AstStructType;
+struct AstEnumType;
 struct AstProcType;
+struct AstPtrType;
+struct AstMultiPtrType;
+struct AstSliceType;
+struct AstArrayType;
+struct AstDynArrayType;
+struct AstMapType;
+struct AstMatrixType;
+struct AstBitsetType;
+struct AstNamedType;
+struct AstParamType;
+struct AstParenType;
+struct AstDistinctType;
+struct AstEmptyStmt;
+struct AstExprStmt;
+struct AstAssignStmt;
 struct AstBlockStmt;
+struct AstImportStmt;
+struct AstPackageStmt;
+struct AstDeferStmt;
+struct AstReturnStmt;
+struct AstBreakStmt;
+struct AstContinueStmt;
+struct AstFallthroughStmt;
+struct AstForeignImportStmt;
+struct AstIfStmt;
+struct AstWhenStmt;
+struct AstForStmt;
 struct AstDeclStmt;
+struct AstUsingStmt;
+
+struct AstNode;
+struct AstFile;
+struct AstRemap;
+
+template<typename T>
+struct AstRef;
+struct AstTypeKey;
 
 using AstStringRef = StringRef;
 
@@ -35,6 +101,7 @@ struct AstIDArray {
 	[[nodiscard]] constexpr auto length() const { return length_; }
 private:
 	friend struct AstFile;
+	friend struct AstRemap;
 	Uint64 offset_ = 0; // The offset into Ast::ids_
 	Uint64 length_ = 0; // The length of the array.
 	// The actual IDs are essentially:
@@ -58,37 +125,165 @@ struct AstRefArray {
 	[[nodiscard]] THOR_FORCEINLINE constexpr auto length() const { return id_.length(); }
 private:
 	friend struct AstFile;
+	friend struct AstRemap;
 	AstIDArray id_;
 };
 
+// A list of types, for giving each of them a number at compile time.
+template<typename... Ts>
+struct AstTypeList {
+	static inline constexpr const auto LENGTH = Uint32(sizeof...(Ts));
+	// The index of [T] in the list, LENGTH when it is not in it.
+	template<typename T>
+	static constexpr Uint32 index() {
+		Uint32 i = 0;
+		(void)((is_same<T, Ts> || (i++, false)) || ...);
+		return i;
+	}
+};
+
+// Every type of node which can be made with AstFile::create. The index of a type
+// in here is the number of its region, so the regions of every file are laid out
+// the same way whatever order the types are first used in. Add new node types to the
+// end to keep the layout of saved files.
+using AstNodeTypes = AstTypeList<
+	AstField,
+	AstDirective,
+	AstBinExpr,
+	AstUnaryExpr,
+	AstIfExpr,
+	AstWhenExpr,
+	AstForInExpr,
+	AstDerefExpr,
+	AstOrReturnExpr,
+	AstOrBreakExpr,
+	AstOrContinueExpr,
+	AstCallExpr,
+	AstIdentExpr,
+	AstUndefExpr,
+	AstContextExpr,
+	AstProcExpr,
+	AstSliceExpr,
+	AstIndexExpr,
+	AstIntExpr,
+	AstFloatExpr,
+	AstStringExpr,
+	AstImaginaryExpr,
+	AstCompoundExpr,
+	AstCastExpr,
+	AstSelectorExpr,
+	AstAccessExpr,
+	AstAssertExpr,
+	AstTypeExpr,
+	AstTypeIDType,
+	AstUnionType,
+	AstStructType,
+	AstEnumType,
+	AstProcType,
+	AstPtrType,
+	AstMultiPtrType,
+	AstSliceType,
+	AstArrayType,
+	AstDynArrayType,
+	AstMapType,
+	AstMatrixType,
+	AstBitsetType,
+	AstNamedType,
+	AstParamType,
+	AstParenType,
+	AstDistinctType,
+	AstEmptyStmt,
+	AstExprStmt,
+	AstAssignStmt,
+	AstBlockStmt,
+	AstImportStmt,
+	AstPackageStmt,
+	AstDeferStmt,
+	AstReturnStmt,
+	AstBreakStmt,
+	AstContinueStmt,
+	AstFallthroughStmt,
+	AstForeignImportStmt,
+	AstIfStmt,
+	AstWhenStmt,
+	AstForStmt,
+	AstDeclStmt,
+	AstUsingStmt
+>;
+
 struct AstSlabID {
-	// Only 6-bit slab index (2^6 = 64)
+	// Only 6-bit region index (2^6 = 64)
 	static inline constexpr const auto MAX = 64_u32;
+	static_assert(AstNodeTypes::LENGTH <= MAX, "Too many node types for a 6-bit region index");
+
+	// Renumbers the references held by a node, see AstFile::merge.
+	using Remap = void (*)(void* node, AstRemap& remap);
+
+	// Appends the nodes a node refers to, see AstFile::linearise. False when out
+	// of memory.
+	using Children = Bool (*)(const AstFile& ast, void* node, Array<AstRef<AstNode>>& children);
+
+	// Makes the AstTypeKey of a node of [remap->from_] as it is once merged, see
+	// AstFile::merge, or of a node as it is when [remap] is nullptr, see
+	// AstFile::load. False when the node cannot be shared.
+	using Key = Bool (*)(const void* node, AstRemap* remap, AstTypeKey& key);
+
 	template<typename T>
-	static Uint32 id([[maybe_unused]] System& sys) {
-		static const Uint32 id = s_id++;
-		// We've run out of IDs for slabs. This indicates that there are too many
-		// distinct types and they will need to be consolidated. The scheme used by
-		// this representation can only support up to [MAX] unique types.
-		THOR_ASSERT(sys, id <= MAX);
-		return id;
+	static constexpr Uint32 id() {
+		constexpr auto ID = AstNodeTypes::index<T>();
+		static_assert(ID < AstNodeTypes::LENGTH, "Not in AstNodeTypes");
+		return ID;
 	}
+
+	// The Remap for the nodes of region [id], nullptr when there is no such region.
+	static Remap remap(Uint32 id);
+
+	// The Children for the nodes of region [id], nullptr when there is no such
+	// region.
+	static Children children(Uint32 id);
+
+	// The Key for the nodes of region [id], nullptr when there is no such region.
+	static Key key(Uint32 id);
+
+	// The size of the nodes of region [id], zero when there is no such region.
+	static Ulen size(Uint32 id);
+
 private:
-	static inline Uint32 s_id;
+	template<typename T>
+	static void remap_node(void* node, AstRemap& remap) {
+		// Nodes which hold no references have nothing to renumber.
+		if constexpr (requires(T& t, AstRemap& r) { t.visit(r); }) {
+			static_cast<T*>(node)->visit(remap);
+		}
+	}
+	template<typename T>
+	static Bool children_node(const AstFile& ast, void* node, Array<AstRef<AstNode>>& children);
+	template<typename T>
+	static Bool key_node(const void* node, AstRemap* remap, AstTypeKey& key);
+	template<typename L>
+	struct Tables;
 };
 
+// Every node which holds references has a visit(fn) which calls [fn] with each
+// AstRef, AstRefArray and AstStringRef of the node in the order of its fields.
+// This is how AstFile::merge renumbers a node and how AstFile::linearise finds
+// its children.
 struct AstNode {
-	// Only 12-bit node index (2^12 = 2048)
+	// Together with AstID::MAX the 26-bit index of a node of one kind.
 	static inline constexpr const auto MAX = 4096_u32;
 	constexpr AstNode(Uint32 offset)
 		: offset{offset}
 	{
 	}
+	// Source location, see SourceManager. A type node is shared by every spelling
+	// of the same type, see AstFile::create, so its location is only that of the
+	// first spelling and is hidden by AstType. A diagnostic about a type uses the
+	// location of the node which spells it.
 	Uint32 offset;
 };
 
 struct AstID {
-	// Only 14-bit pool index (2^14 = 16384)
+	// Together with AstNode::MAX the 26-bit index of a node of one kind.
 	static inline constexpr const auto MAX = 16384_u32;
 	THOR_FORCEINLINE constexpr AstID() = default;
 	THOR_FORCEINLINE constexpr AstID(Unit) : AstID{} {}
@@ -106,6 +301,8 @@ private:
 	template<typename>
 	friend struct AstRef;
 	friend struct AstFile;
+	friend struct AstRemap;
+	friend struct AstTypeKey;
 	Uint32 value_ = ~0_u32;
 };
 static_assert(sizeof(AstID) == 4);
@@ -132,6 +329,8 @@ struct AstRef {
 	}
 private:
 	friend struct AstFile;
+	friend struct AstRemap;
+	friend struct AstTypeKey;
 	AstID id_;
 };
 
@@ -144,6 +343,11 @@ struct AstField : AstNode {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+		fn(expr);
+	}
 	AstRef<AstExpr> operand;
 	AstRef<AstExpr> expr; // Optional value associated with attribute, enum, or parameter
 };
@@ -159,6 +363,11 @@ struct AstDirective : AstNode {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(name);
+		fn(args);
+	}
 	AstStringRef         name;
 	AstRefArray<AstExpr> args;
 };
@@ -224,6 +433,11 @@ struct AstBinExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(lhs);
+		fn(rhs);
+	}
 	AstRef<AstExpr> lhs;
 	AstRef<AstExpr> rhs;
 	OperatorKind    op;
@@ -238,6 +452,10 @@ struct AstUnaryExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+	}
 	AstRef<AstExpr> operand;
 	OperatorKind    op;
 };
@@ -252,6 +470,12 @@ struct AstIfExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(cond);
+		fn(on_true);
+		fn(on_false);
+	}
 	AstRef<AstExpr> cond;
 	AstRef<AstExpr> on_true;
 	AstRef<AstExpr> on_false;
@@ -267,6 +491,12 @@ struct AstWhenExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(cond);
+		fn(on_true);
+		fn(on_false);
+	}
 	AstRef<AstExpr> cond;
 	AstRef<AstExpr> on_true;
 	AstRef<AstExpr> on_false;
@@ -281,6 +511,11 @@ struct AstForInExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(lhs);
+		fn(rhs);
+	}
 	AstRefArray<AstExpr> lhs;
 	AstRef<AstExpr>  rhs;
 };
@@ -293,6 +528,10 @@ struct AstDerefExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+	}
 	AstRef<AstExpr> operand;
 };
 
@@ -304,6 +543,10 @@ struct AstOrReturnExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+	}
 	AstRef<AstExpr> operand;
 };
 
@@ -315,6 +558,10 @@ struct AstOrBreakExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+	}
 	AstRef<AstExpr> operand;
 };
 
@@ -326,6 +573,10 @@ struct AstOrContinueExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+	}
 	AstRef<AstExpr> operand;
 };
 
@@ -347,6 +598,11 @@ struct AstCallExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+		fn(args);
+	}
 	AstRef<AstExpr>       operand;
 	AstRefArray<AstField> args;
 };
@@ -360,6 +616,10 @@ struct AstIdentExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(ident);
+	}
 	AstStringRef ident;
 };
 
@@ -393,6 +653,11 @@ struct AstProcExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(type);
+		fn(body);
+	}
 	AstRef<AstProcType>   type;
 	AstRef<AstBlockStmt>  body;
 };
@@ -418,6 +683,12 @@ struct AstSliceExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+		fn(lhs);
+		fn(rhs);
+	}
 	AstRef<AstExpr> operand;
 	AstRef<AstExpr> lhs; // Optional
 	AstRef<AstExpr> rhs; // Optional
@@ -440,6 +711,12 @@ struct AstIndexExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+		fn(lhs);
+		fn(rhs);
+	}
 	AstRef<AstExpr> operand;
 	AstRef<AstExpr> lhs;
 	AstRef<AstExpr> rhs; // Optional
@@ -480,6 +757,10 @@ struct AstStringExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(value);
+	}
 	AstStringRef value;
 };
 
@@ -504,6 +785,10 @@ struct AstCompoundExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(fields);
+	}
 	AstRefArray<AstField> fields;
 };
 
@@ -524,6 +809,11 @@ struct AstCastExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(type);
+		fn(expr);
+	}
 	AstRef<AstType> type; // When !type this is an auto_cast
 	AstRef<AstExpr> expr;
 };
@@ -538,6 +828,10 @@ struct AstSelectorExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(name);
+	}
 	AstStringRef name;
 };
 
@@ -556,6 +850,11 @@ struct AstAccessExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+		fn(field);
+	}
 	AstRef<AstExpr> operand;
 	AstStringRef    field;
 	Bool            is_arrow;
@@ -575,6 +874,11 @@ struct AstAssertExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(operand);
+		fn(type);
+	}
 	AstRef<AstExpr> operand;
 	AstRef<AstType> type; // Optional
 };
@@ -589,6 +893,10 @@ struct AstTypeExpr : AstExpr {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(type);
+	}
 	AstRef<AstType> type;
 };
 
@@ -668,6 +976,9 @@ struct AstType : AstNode {
 		return is_type<T>() ? static_cast<const T*>(this) : nullptr;
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	// Hides AstNode::offset so reading the location of a shared type, which may
+	// be that of some other spelling, does not compile.
+	void offset() const = delete;
 	Kind kind;
 };
 
@@ -688,6 +999,10 @@ struct AstUnionType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(types);
+	}
 	AstRefArray<AstType> types;
 };
 
@@ -699,6 +1014,10 @@ struct AstStructType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(decls);
+	}
 	AstRefArray<AstStmt> decls;
 };
 
@@ -711,6 +1030,11 @@ struct AstEnumType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(base);
+		fn(enums);
+	}
 	AstRef<AstType>       base;
 	AstRefArray<AstField> enums;
 };
@@ -724,6 +1048,11 @@ struct AstProcType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(fields);
+		fn(types);
+	}
 	AstRefArray<AstStmt> fields;
 	AstRefArray<AstStmt> types;
 };
@@ -736,6 +1065,10 @@ struct AstPtrType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(base);
+	}
 	AstRef<AstType> base;
 };
 
@@ -747,6 +1080,10 @@ struct AstMultiPtrType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(base);
+	}
 	AstRef<AstType> base;
 };
 
@@ -758,6 +1095,10 @@ struct AstSliceType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(base);
+	}
 	AstRef<AstType> base;
 };
 
@@ -770,6 +1111,11 @@ struct AstArrayType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(size);
+		fn(base);
+	}
 	AstRef<AstExpr> size; // Optional, empty represents [?]T
 	AstRef<AstType> base;
 };
@@ -782,6 +1128,10 @@ struct AstDynArrayType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(base);
+	}
 	AstRef<AstType> base;
 };
 
@@ -794,6 +1144,11 @@ struct AstMapType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(kt);
+		fn(vt);
+	}
 	AstRef<AstType> kt;
 	AstRef<AstType> vt;
 };
@@ -808,6 +1163,12 @@ struct AstMatrixType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(rows);
+		fn(cols);
+		fn(base);
+	}
 	AstRef<AstExpr> rows;
 	AstRef<AstExpr> cols;
 	AstRef<AstType> base;
@@ -822,6 +1183,11 @@ struct AstBitsetType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(expr);
+		fn(type);
+	}
 	AstRef<AstExpr> expr;
 	AstRef<AstType> type; // Optional
 };
@@ -835,6 +1201,11 @@ struct AstNamedType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(pkg);
+		fn(name);
+	}
 	AstStringRef pkg; // Optional package name
 	AstStringRef name;
 };
@@ -848,6 +1219,11 @@ struct AstParamType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(name);
+		fn(exprs);
+	}
 	AstRef<AstNamedType> name;
 	AstRefArray<AstExpr> exprs;
 };
@@ -860,6 +1236,10 @@ struct AstParenType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(type);
+	}
 	AstRef<AstType> type;
 };
 
@@ -871,6 +1251,10 @@ struct AstDistinctType : AstType {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(type);
+	}
 	AstRef<AstType> type;
 };
 
@@ -937,6 +1321,10 @@ struct AstExprStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(expr);
+	}
 	AstRef<AstExpr> expr;
 };
 
@@ -953,6 +1341,11 @@ struct AstAssignStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(lhs);
+		fn(rhs);
+	}
 	AstRefArray<AstExpr> lhs;
 	AstRefArray<AstExpr> rhs;
 	AssignKind           kind;
@@ -966,6 +1359,10 @@ struct AstBlockStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(stmts);
+	}
 	AstRefArray<AstStmt> stmts;
 };
 
@@ -978,6 +1375,11 @@ struct AstImportStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(alias);
+		fn(expr);
+	}
 	AstStringRef          alias;
 	AstRef<AstStringExpr> expr;
 };
@@ -990,6 +1392,10 @@ struct AstPackageStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(name);
+	}
 	AstStringRef name;
 };
 
@@ -1001,6 +1407,10 @@ struct AstDeferStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(stmt);
+	}
 	AstRef<AstStmt> stmt;
 };
 
@@ -1012,6 +1422,10 @@ struct AstReturnStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(exprs);
+	}
 	AstRefArray<AstExpr> exprs;
 };
 
@@ -1023,6 +1437,10 @@ struct AstBreakStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(label);
+	}
 	AstStringRef label;
 };
 
@@ -1034,6 +1452,10 @@ struct AstContinueStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(label);
+	}
 	AstStringRef label;
 };
 
@@ -1055,6 +1477,11 @@ struct AstForeignImportStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(ident);
+		fn(names);
+	}
 	AstStringRef         ident; // Optional
 	AstRefArray<AstExpr> names;
 };
@@ -1074,6 +1501,13 @@ struct AstIfStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(init);
+		fn(cond);
+		fn(on_true);
+		fn(on_false);
+	}
 	AstRef<AstStmt> init; // Optional
 	AstRef<AstExpr> cond;
 	AstRef<AstStmt> on_true;
@@ -1093,6 +1527,12 @@ struct AstWhenStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(cond);
+		fn(on_true);
+		fn(on_false);
+	}
 	AstRef<AstExpr>      cond;
 	AstRef<AstBlockStmt> on_true;
 	AstRef<AstBlockStmt> on_false; // Optional
@@ -1115,6 +1555,14 @@ struct AstForStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(in);
+		fn(init);
+		fn(cond);
+		fn(post);
+		fn(body);
+	}
 	AstRef<AstStmt>      in;   // Optional
 	AstRefArray<AstStmt> init; // Optional
 	AstRef<AstExpr>      cond; // Optional
@@ -1146,6 +1594,14 @@ struct AstDeclStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(lhs);
+		fn(type);
+		fn(rhs);
+		fn(directives);
+		fn(attributes);
+	}
 	Bool                      is_const;
 	Bool                      is_using;
 	List                      lhs;
@@ -1168,6 +1624,10 @@ struct AstUsingStmt : AstStmt {
 	{
 	}
 	void dump(const AstFile& ast, StringBuilder& builder, Ulen nest) const;
+	template<typename F>
+	void visit(F&& fn) {
+		fn(expr);
+	}
 	AstRef<AstExpr> expr;
 };
 
@@ -1203,8 +1663,165 @@ static_assert(!is_polymorphic<AstFallthroughStmt>, "Cannot be polymorphic");
 static_assert(!is_polymorphic<AstIfStmt>, "Cannot be polymorphic");
 static_assert(!is_polymorphic<AstDeclStmt>, "Cannot be polymorphic");
 
+// The structure of a type node which every spelling of the same type shares, see
+// AstFile::create. Only types which refer to nothing but other types and names
+// are shared: ^T, [^]T, []T, [?]T, [dynamic]T, map[K]V, Name, (T) and typeid.
+// Every distinct T is a new type so those are never shared.
+struct AstTypeKey {
+	Uint32 kind   = 0; // See AstSlabID
+	Uint32 length = 0; // # of words of data
+	Uint32 data[4];    // The IDs of the types and the names referred to
+
+	// The map for make when the references are to be kept as they are.
+	struct Identity {
+		AstID operator()(AstID id) const { return id; }
+		AstStringRef operator()(AstStringRef ref) const { return ref; }
+	};
+
+	// Make the key of [node] into [key] with every reference passed through [map]
+	// first. False when [node] cannot be shared.
+	template<typename T, typename M>
+	static Bool make(T& node, M& map, AstTypeKey& key) {
+		if constexpr (!DerivedFrom<T, AstType> || Same<T, AstDistinctType>) {
+			return false;
+		} else {
+			Builder<M> builder{map, key};
+			key.kind = AstSlabID::id<T>();
+			if constexpr (requires(T& t) { t.visit(builder); }) {
+				node.visit(builder);
+			}
+			return builder.ok;
+		}
+	}
+
+	[[nodiscard]] constexpr Hash hash(Hash h = FNV_OFFSET) const {
+		h = Thor::hash(kind, h);
+		for (Uint32 i = 0; i < length; i++) {
+			h = Thor::hash(data[i], h);
+		}
+		return h;
+	}
+	[[nodiscard]] constexpr Bool operator==(const AstTypeKey& other) const {
+		if (kind != other.kind || length != other.length) {
+			return false;
+		}
+		for (Uint32 i = 0; i < length; i++) {
+			if (data[i] != other.data[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	template<typename M>
+	struct Builder {
+		template<typename T>
+		void operator()(AstRef<T>& ref) {
+			// An expression, such as the size of an array, is never the same twice.
+			if constexpr (DerivedFrom<T, AstType>) {
+				push(map(ref.id_).value_);
+			} else if (ref) {
+				ok = false;
+			} else {
+				push(~0_u32);
+			}
+		}
+		template<typename T>
+		void operator()(AstRefArray<T>&) {
+			ok = false;
+		}
+		void operator()(AstStringRef& ref) {
+			const auto mapped = map(ref);
+			push(mapped.offset);
+			push(mapped.length);
+		}
+		void push(Uint32 word) {
+			if (key.length < sizeof key.data / sizeof *key.data) {
+				key.data[key.length++] = word;
+			} else {
+				ok = false;
+			}
+		}
+		M&          map;
+		AstTypeKey& key;
+		Bool        ok = true;
+	};
+};
+
+// The hooks of a pass P for every kind of node, see AstFile::walk. Each table has
+// an entry for every type of AstNodeTypes which calls the hook of P taking that
+// type, or the nearest base of it, and does nothing when there is none.
+template<typename P, typename L>
+struct AstHooks;
+
+template<typename P, typename... Ts>
+struct AstHooks<P, AstTypeList<Ts...>> {
+	using Enter = Bool (*)(P& pass, const void* node, AstRef<AstNode> ref);
+	using Leave = void (*)(P& pass, const void* node, AstRef<AstNode> ref);
+
+	template<typename T>
+	static Bool enter(P& pass, const void* node, AstRef<AstNode> ref) {
+		if constexpr (requires(P& p, const T& n, AstRef<AstNode> r) { { p.enter(n, r) } -> Same<Bool>; }) {
+			return pass.enter(*static_cast<const T*>(node), ref);
+		} else if constexpr (requires(P& p, const T& n, AstRef<AstNode> r) { p.enter(n, r); }) {
+			pass.enter(*static_cast<const T*>(node), ref);
+		}
+		return true;
+	}
+	template<typename T>
+	static inline constexpr const Bool HAS_LEAVE =
+		requires(P& p, const T& n, AstRef<AstNode> r) { p.leave(n, r); };
+
+	template<typename T>
+	static void leave(P& pass, const void* node, AstRef<AstNode> ref) {
+		if constexpr (HAS_LEAVE<T>) {
+			pass.leave(*static_cast<const T*>(node), ref);
+		}
+	}
+
+	static inline constexpr const Enter ENTER[] = { enter<Ts>... };
+	static inline constexpr const Leave LEAVE[] = { leave<Ts>... };
+
+	// When no node has a leave hook the walk need not come back to any.
+	static inline constexpr const Bool LEAVES = (HAS_LEAVE<Ts> || ...);
+};
+
+// The trees of an AstFile in the order of a pre-order walk: every node is
+// followed by the nodes of its subtree, so a pass over the whole tree is a
+// forward scan and a subtree is skipped by adding its size. Only the IDs are
+// held here, the nodes stay where they are in the AstFile.
+struct AstLinear {
+	static inline constexpr const auto NONE = ~0_u32;
+
+	struct Node {
+		AstID  id;
+		Uint32 kind;   // See AstSlabID
+		Uint32 size;   // # of nodes in the subtree, this one included
+		Uint32 parent; // Index of the parent node, NONE for a root
+	};
+
+	AstLinear(Array<Node>&& nodes)
+		: nodes_{move(nodes)}
+	{
+	}
+
+	[[nodiscard]] THOR_FORCEINLINE Slice<const Node> nodes() const { return nodes_.slice(); }
+	[[nodiscard]] THOR_FORCEINLINE Ulen length() const { return nodes_.length(); }
+	THOR_FORCEINLINE const Node& operator[](Ulen index) const { return nodes_[index]; }
+
+	// The index of the first node after the subtree of node [index].
+	[[nodiscard]] THOR_FORCEINLINE Ulen skip(Ulen index) const { return index + nodes_[index].size; }
+
+private:
+	Array<Node> nodes_;
+};
+
 struct AstFile {
-	static Maybe<AstFile> create(System& sys, StringView filename);
+	// Address space is reserved for up to [capacity] nodes of each kind, at most
+	// NODES, as each kind is first made. A node takes at least one token so the
+	// number of tokens of the file is enough.
+	static Maybe<AstFile> create(System& sys, StringView filename, Ulen capacity);
 	static Maybe<AstFile> load(System& sys, Stream& stream);
 
 	Bool save(Stream& stream) const;
@@ -1217,30 +1834,52 @@ struct AstFile {
 	~AstFile();
 
 	static inline constexpr const auto MAX = AstID::MAX * AstNode::MAX;
-
+	// The low bits of an AstID index the nodes of one kind and the high bits are
+	// the kind, see AstSlabID and [regions_].
+	static inline constexpr const auto SHIFT = 26_u32;
+	static_assert(MAX == 1_u32 << SHIFT);
+	// The most nodes of each kind a file reserves address space for, less than
+	// MAX. A region reserves its capacity times the size of its node, which
+	// over every kind is about 1.2 KiB of address space for each token of a
+	// file. Nothing is committed until the nodes are made.
+	static inline constexpr const auto NODES = 1_u32 << 24;
+
+	// Make a node of type T from [args]. A type which can be shared, see
+	// AstTypeKey, is only made the first time it is spelled and every later
+	// spelling gives the same AstRef. Those with the same structure are the same
+	// type if and only if their AstRef is the same. A shared type has the location
+	// of where it was first spelled.
 	template<typename T, typename... Ts>
 	AstRef<T> create(Ts&&... args) {
-		auto slab_idx = AstSlabID::id<T>(sys_);
-		if (slab_idx >= slabs_.length() && !slabs_.resize(slab_idx + 1)) {
-			return {};
+		if constexpr (DerivedFrom<T, AstType>) {
+			T node{forward<Ts>(args)...};
+			AstTypeKey key;
+			AstTypeKey::Identity identity;
+			if (!AstTypeKey::make(node, identity, key)) {
+				return make<T>(move(node));
+			}
+			if (auto found = types_.find(key)) {
+				return found->v;
+			}
+			auto ref = make<T>(move(node));
+			if (ref && (!types_.insert(key, ref.id_) || !shared_.push_back(ref.id_))) {
+				// Out of memory
+				return {};
+			}
+			return ref;
+		} else {
+			return make<T>(forward<Ts>(args)...);
 		}
-		auto& slab = slabs_[slab_idx];
-		if (!slab) {
-			slab.emplace(slabs_.allocator(), sizeof(T), AstNode::MAX);
-		}
-		if (auto slab_ref = slab->allocate()) {
-			new ((*slab)[*slab_ref], Nat{}) T{forward<Ts>(args)...};
-			return AstID { slab_idx * MAX + slab_ref->index };
-		}
-		return {};
 	}
 
 	// Lookup an Ast node by AstRef
 	template<typename T>
 	THOR_FORCEINLINE constexpr const T& operator[](AstRef<T> ref) const {
-		const auto slab_idx = ref.id_.value_ / MAX;
-		const auto slab_ref = ref.id_.value_ % MAX;
-		return *reinterpret_cast<const T*>((*slabs_[slab_idx])[SlabRef { slab_ref }]);
+		return *reinterpret_cast<const T*>(address<T>(ref.id_));
+	}
+	template<typename T>
+	THOR_FORCEINLINE constexpr T& operator[](AstRef<T> ref) {
+		return *reinterpret_cast<T*>(address<T>(ref.id_));
 	}
 
 	// Lookup a StringView by AstStringRef
@@ -1270,25 +1909,87 @@ struct AstFile {
 		return string_table_;
 	}
 
+	// The number of nodes made with create or merged in.
+	THOR_FORCEINLINE Uint64 nodes() const { return nodes_; }
+
+	// The most nodes of each kind there is address space for.
+	THOR_FORCEINLINE Uint32 capacity() const { return capacity_; }
+
+	// Address space could not be reserved for a kind of node, which made create
+	// or merge fail. Unlike running out of memory it is worth telling the user.
+	THOR_FORCEINLINE Bool is_unreserved() const { return unreserved_; }
+
+	// The nodes of [kind], see AstSlabID. Missing when none were made.
+	THOR_FORCEINLINE const Maybe<Region>& nodes(Uint32 kind) const { return regions_[kind]; }
+
+	// Copy every node, list and string of [other] into this file, renumbering all
+	// of the references held in them to match. Pass references to nodes of
+	// [other] through the result to get the same nodes in this file. Missing when
+	// out of memory or IDs.
+	Maybe<AstRemap> merge(const AstFile& other);
+
+	// Walk the trees of [roots] depth first and in order without recursing. For a
+	// node of type T pass.enter(const T&, AstRef<AstNode>) is called before the
+	// children of the node and pass.leave(const T&, AstRef<AstNode>) after them.
+	// A hook taking a base such as AstExpr or AstNode is called for every node
+	// derived from it and hooks which are not needed can be left out. The
+	// children of a node are skipped when enter returns a Bool which is false.
+	// False when out of memory.
+	template<typename P>
+	Bool walk(Slice<const AstRef<AstStmt>> roots, P& pass) const;
+
+	// Walk the trees of [roots] in order and list every node reached, see
+	// AstLinear. A deferred body which was never parsed is not reached. Missing
+	// when out of memory.
+	Maybe<AstLinear> linearise(Slice<const AstRef<AstStmt>> roots) const;
+
 private:
+	friend struct AstRemap;
 	[[nodiscard]] AstIDArray insert(Slice<const AstID> ids);
 
-	AstFile(System& sys, StringTable&& string_table, AstStringRef filename)
+	AstFile(System& sys, StringTable&& string_table, AstStringRef filename, Uint32 capacity)
 		: sys_{sys}
 		, string_table_{move(string_table)}
 		, filename_{filename}
-		, slabs_{sys.allocator}
+		, capacity_{capacity}
 		, ids_{sys.allocator}
+		, types_{sys.allocator}
+		, shared_{sys.allocator}
 	{
 	}
 
-	AstFile(System& sys, StringTable&& string_table, AstStringRef filename, Array<Maybe<Slab>>&& slabs, Array<AstID>&& ids)
-		: sys_{sys}
-		, string_table_{move(string_table)}
-		, filename_{filename}
-		, slabs_{move(slabs)}
-		, ids_{move(ids)}
-	{
+	template<typename T, typename... Ts>
+	AstRef<T> make(Ts&&... args) {
+		constexpr auto kind = AstSlabID::id<T>();
+		auto& region = regions_[kind];
+		if (!region) {
+			if (auto made = Region::create(sys_, sizeof(T), capacity_)) {
+				region = move(*made);
+			} else {
+				unreserved_ = true;
+				return {};
+			}
+		}
+		if (auto index = region->allocate()) {
+			new ((*region)[*index], Nat{}) T{forward<Ts>(args)...};
+			nodes_++;
+			return AstID { (kind << SHIFT) | *index };
+		}
+		return {};
+	}
+
+	// The address of the node [id]. A node of a concrete type is found in the
+	// region of that type with its size known, any other is found in the region
+	// given by the kind in [id]. Neither divides.
+	template<typename T>
+	THOR_FORCEINLINE Uint8* address(AstID id) const {
+		const auto index = id.value_ & (MAX - 1);
+		if constexpr (AstNodeTypes::index<T>() < AstNodeTypes::LENGTH) {
+			return regions_[AstSlabID::id<T>()]->data() + sizeof(T) * index;
+		} else {
+			const auto& region = *regions_[id.value_ >> SHIFT];
+			return region.data() + region.size() * index;
+		}
 	}
 
 	// The flattened Ast structure is held here with nodes indexing these. In
@@ -1296,23 +1997,142 @@ private:
 	//  * AstStringRef is an offset into [string_table_] which is just a list of
 	//    UTF-8 characters. The AstStringRef also stores a Uint32 length for when
 	//    to stop reading the string in the table.
-	//  * AstRef<T> is a typed AstID which indexes [slab_] based on the type,
-	//    which then further indexes [Slab::caches_], which then further indexes
-	//    [Pool::data_]. The triple indirection works by decomposing a single
-	//    Uint32 index into a 6-bit [slab_] index. A 12-bit [Slab::caches_] index,
-	//    and a 14-bit [Pool::data_] index. You can think of reading the data for
-	//    a AstRef<T> or AstID as slabs_[d0(id)].caches_[d1(id)].data_[d2(id)]
-	//    where d0, d1, and d2 are decoding functions which take 6, 12 and 14 bits
-	//    from the 32-bit [id] respectively.
+	//  * AstRef<T> is a typed AstID which is decomposed into a 6-bit kind in the
+	//    high bits and a 26-bit index in the low bits. The kind indexes
+	//    [regions_], one for each type in AstNodeTypes, and the index is that of
+	//    the node in the region. A Region is a single range of reserved address
+	//    space holding every node of its kind one after another, so reading the
+	//    data for an AstRef<T> or AstID is regions_[id >> 26].data_[id & mask]
+	//    with one load for the region and one for the node.
 	//  * AstRefArray<T> is a typed AstIDArray which indexes [ids_] based on an
 	//    offset and length stored in the AstRefArray itself. The [ids_] array is
 	//    just an array of AstID, i.e Uint32.
-	System&            sys_;
-	StringTable        string_table_;
-	AstStringRef       filename_;
-	Array<Maybe<Slab>> slabs_;
-	Array<AstID>       ids_;
-};
+	//  * A type which can be shared is found in [types_] by its AstTypeKey. The
+	//    same types are listed in [shared_] in the order they were made, which
+	//    has every type after those it refers to.
+	System&                sys_;
+	StringTable            string_table_;
+	AstStringRef           filename_;
+	Uint32                 capacity_;
+	Bool                   unreserved_ = false;
+	Maybe<Region>          regions_[AstNodeTypes::LENGTH];
+	Array<AstID>           ids_;
+	Map<AstTypeKey, AstID> types_;
+	Array<AstID>           shared_;
+	Uint64                 nodes_ = 0;
+};
+
+// How the references of one AstFile are renumbered when it is merged into
+// another, see AstFile::merge. Nodes are moved along by the number of nodes of
+// their type already in the file, lists by the number of IDs and strings are
+// interned again. A type shared in the other file which is the same as one
+// shared in this file becomes that one instead and is not copied, which moves
+// the nodes of its kind after it down by one.
+struct AstRemap {
+	template<typename T>
+	void operator()(AstRef<T>& ref) {
+		ref.id_ = (*this)(ref.id_);
+	}
+	template<typename T>
+	void operator()(AstRefArray<T>& ref) {
+		if (!ref.is_empty()) {
+			ref.id_.offset_ += ids_;
+		}
+	}
+	void operator()(AstStringRef& ref) {
+		if (ref) {
+			ref = ast_.insert(from_[ref]);
+			ok_ = ok_ && ref.is_valid();
+		}
+	}
+	[[nodiscard]] AstID operator()(AstID id) {
+		if (!id) {
+			return id;
+		}
+		const auto kind = id.value_ >> AstFile::SHIFT;
+		if (kinds_ & (1_u64 << kind)) {
+			if (auto found = types_.find(id.value_)) {
+				return found->v;
+			}
+			// Moved down by the nodes before it which were not copied.
+			const auto& dropped = dropped_[kind];
+			const auto index = id.value_ & (AstFile::MAX - 1);
+			Ulen lo = 0;
+			Ulen hi = dropped.length();
+			while (lo < hi) {
+				const auto mid = lo + (hi - lo) / 2;
+				if (dropped[mid] < index) {
+					lo = mid + 1;
+				} else {
+					hi = mid;
+				}
+			}
+			return AstID { id.value_ - Uint32(lo) + offsets_[kind] };
+		}
+		return AstID { id.value_ + offsets_[kind] };
+	}
+private:
+	friend struct AstFile;
+	AstRemap(AstFile& ast, const AstFile& from)
+		: ast_{ast}
+		, from_{from}
+		, types_{ast.sys_.allocator}
+		, dropped_{ast.sys_.allocator}
+	{
+	}
+	AstFile&              ast_;
+	const AstFile&        from_;
+	Uint32                offsets_[AstSlabID::MAX + 1] = {}; // Added to the IDs of each kind
+	Uint64                ids_ = 0;                          // Added to the offsets of lists
+	Map<Uint32, AstID>    types_;                            // Shared types which are already in ast_
+	Array<Array<Uint32>>  dropped_;                          // Indices of those for each kind, ascending
+	Uint64                kinds_ = 0;                        // The kinds in types_
+	Bool                  ok_ = true;
+};
+
+template<typename P>
+Bool AstFile::walk(Slice<const AstRef<AstStmt>> roots, P& pass) const {
+	using Hooks = AstHooks<P, AstNodeTypes>;
+	// A node still to be entered or, once its children are done, left.
+	struct Visit {
+		AstID id;
+		Bool  leave;
+	};
+	Array<Visit> stack{sys_.allocator};
+	Array<AstRef<AstNode>> children{sys_.allocator};
+	for (Ulen i = roots.length(); i-- > 0; /**/) {
+		if (roots[i] && !stack.push_back({ roots[i].id_, false })) {
+			return false;
+		}
+	}
+	while (!stack.is_empty()) {
+		const auto visit = stack.last();
+		stack.pop_back();
+		const auto kind = visit.id.value_ >> SHIFT;
+		const auto node = address<AstNode>(visit.id);
+		if (visit.leave) {
+			Hooks::LEAVE[kind](pass, node, visit.id);
+			continue;
+		}
+		if (Hooks::LEAVES && !stack.push_back({ visit.id, true })) {
+			return false;
+		}
+		if (!Hooks::ENTER[kind](pass, node, visit.id)) {
+			continue;
+		}
+		children.clear();
+		if (!AstSlabID::children(kind)(*this, node, children)) {
+			return false;
+		}
+		// Pushed last to first so that the first child is entered next.
+		for (Ulen i = children.length(); i-- > 0; /**/) {
+			if (!stack.push_back({ children[i].id_, false })) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
 
 } // namespace Thor
 
@@ -0,0 +1,133 @@
+#include "util/system.h"
+
+#include "diagnostic.h"
+
+namespace Thor {
+
+Diagnostics::~Diagnostics() {
+	for (auto buffer : buffers_) {
+		system_.destroy(buffer);
+	}
+}
+
+Diagnostics::Buffer* Diagnostics::buffer() {
+	auto buffer = system_.create<Buffer>(system_);
+	if (!buffer) {
+		return nullptr;
+	}
+	lock_.lock(sys_);
+	const auto ok = buffers_.push_back(buffer);
+	lock_.unlock(sys_);
+	if (!ok) {
+		system_.destroy(buffer);
+		return nullptr;
+	}
+	return buffer;
+}
+
+Bool Diagnostics::flush() {
+	// Which entry of which buffer, in the order they are written.
+	struct Index {
+		Uint32 buffer;
+		Uint32 entry;
+	};
+
+	lock_.lock(sys_);
+	Bool oom = false;
+	Ulen length = 0;
+	for (auto buffer : buffers_) {
+		length += buffer->entries_.length();
+		oom = oom || buffer->oom_;
+	}
+	Array<Index> order{system_};
+	Array<Index> scratch{system_};
+	if (order.reserve(length) && scratch.resize(length)) {
+		for (Uint32 i = 0; i < buffers_.length(); i++) {
+			for (Uint32 j = 0; j < buffers_[i]->entries_.length(); j++) {
+				// Cannot fail, there is room for every entry.
+				(void)order.push_back({ i, j });
+			}
+		}
+	} else {
+		oom = true;
+	}
+
+	// Merge sort by location which keeps the order of those at the same location.
+	auto location = [&](Index index) {
+		return buffers_[index.buffer]->entries_[index.entry].location;
+	};
+	auto src = order.data();
+	auto dst = scratch.data();
+	const auto n = order.length();
+	for (Ulen width = 1; width < n; width *= 2) {
+		for (Ulen lo = 0; lo < n; lo += 2 * width) {
+			const auto mid = lo + width < n ? lo + width : n;
+			const auto hi = lo + 2 * width < n ? lo + 2 * width : n;
+			auto l = lo, r = mid;
+			for (auto k = lo; k < hi; k++) {
+				if (l < mid && (r >= hi || location(src[l]) <= location(src[r]))) {
+					dst[k] = src[l++];
+				} else {
+					dst[k] = src[r++];
+				}
+			}
+		}
+		auto swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	StringBuilder builder{system_};
+	for (Ulen i = 0; i < n; i++) {
+		const auto buffer = buffers_[src[i].buffer];
+		const auto& entry = buffer->entries_[src[i].entry];
+		sources_.describe(builder, entry.location);
+		builder.put(": ");
+		switch (entry.severity) {
+		case Severity::NOTE:    builder.put("note");    break;
+		case Severity::WARNING: builder.put("warning"); break;
+		case Severity::ERROR:   builder.put("error");   errors_++; break;
+		}
+		builder.put(": ");
+		if (auto text = buffer->text_.result()) {
+			builder.put(text->slice(entry.offset).truncate(entry.length));
+		}
+		builder.put('\n');
+	}
+	if (oom) {
+		builder.put("Out of memory\n");
+	}
+	if (auto result = builder.result()) {
+		if (!result->is_empty()) {
+			sys_.console.write(sys_, *result);
+		}
+	} else {
+		sys_.console.write(sys_, StringView { "Out of memory\n" });
+		oom = true;
+	}
+
+	// The buffers are kept, the threads which reported into them may go on.
+	for (auto buffer : buffers_) {
+		buffer->text_.reset();
+		buffer->entries_.clear();
+		buffer->oom_ = false;
+	}
+	lock_.unlock(sys_);
+	return !oom;
+}
+
+Ulen Diagnostics::errors() {
+	lock_.lock(sys_);
+	auto result = errors_;
+	for (auto buffer : buffers_) {
+		for (const auto& entry : buffer->entries_) {
+			if (entry.severity == Severity::ERROR) {
+				result++;
+			}
+		}
+	}
+	lock_.unlock(sys_);
+	return result;
+}
+
+} // namespace Thor
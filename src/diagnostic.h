@@ -0,0 +1,107 @@
+#ifndef THOR_DIAGNOSTIC_H
+#define THOR_DIAGNOSTIC_H
+#include "util/lock.h"
+#include "util/string.h"
+
+#include "source.h"
+
+namespace Thor {
+
+enum class Severity : Uint8 {
+	NOTE,
+	WARNING,
+	ERROR,
+};
+
+// Every diagnostic of a build is collected here rather than written as it is
+// found. Each thread reports into a buffer of its own without taking a lock and
+// everything is written at once by flush, ordered by location. Files are given
+// their locations in a fixed order so the output is the same however many
+// threads found the diagnostics, and it takes one write to the console.
+struct Diagnostics {
+	struct Buffer {
+		Buffer(Allocator& allocator)
+			: text_{allocator}
+			, entries_{allocator}
+		{
+		}
+
+		// Report [msg] at [location]. Each "{}" in [msg] is replaced by the next
+		// one of [args], which can be anything a StringBuilder can put.
+		template<Ulen E, typename... Ts>
+		void report(Uint32 location, Severity severity, const char (&msg)[E], Ts&&... args) {
+			const auto offset = text_.result() ? text_.result()->length() : 0;
+			format(StringView { msg }, forward<Ts>(args)...);
+			const auto result = text_.result();
+			if (!result || !entries_.push_back({ location, severity, offset, result->length() - offset })) {
+				// Out of memory, flush writes that much instead.
+				oom_ = true;
+			}
+		}
+
+	private:
+		friend struct Diagnostics;
+
+		void format(StringView msg) {
+			text_.put(msg);
+		}
+		template<typename T, typename... Ts>
+		void format(StringView msg, T&& arg, Ts&&... args) {
+			for (Ulen i = 0; i + 1 < msg.length(); i++) {
+				if (msg[i] == '{' && msg[i + 1] == '}') {
+					text_.put(msg.truncate(i));
+					text_.put(arg);
+					return format(msg.slice(i + 2), forward<Ts>(args)...);
+				}
+			}
+			// More arguments than there are "{}", the rest are not used.
+			text_.put(msg);
+		}
+
+		struct Entry {
+			Uint32   location;
+			Severity severity;
+			Ulen     offset; // Of the message in text_
+			Ulen     length;
+		};
+
+		StringBuilder text_;
+		Array<Entry>  entries_;
+		Bool          oom_ = false;
+	};
+
+	Diagnostics(System& sys, SourceManager& sources)
+		: sys_{sys}
+		, sources_{sources}
+		, system_{sys}
+		, buffers_{system_}
+	{
+	}
+	Diagnostics(const Diagnostics&) = delete;
+	Diagnostics(Diagnostics&&) = delete;
+	~Diagnostics();
+
+	// A buffer for one thread to report into, it lives as long as this does. The
+	// result is nullptr when out of memory.
+	Buffer* buffer();
+
+	// Write everything reported so far in the order of their locations and forget
+	// it, the buffers can still be reported into. Must not be called while another
+	// thread is reporting. False when out of memory, which is also written.
+	Bool flush();
+
+	// The number of errors reported so far, including those already flushed.
+	Ulen errors();
+
+private:
+	System&         sys_;
+	SourceManager&  sources_;
+	SystemAllocator system_;
+	Lock            lock_;
+	Array<Buffer*>  buffers_; // Only used with lock_ held
+	Ulen            errors_ = 0; // Flushed so far
+};
+
+} // namespace Thor
+
+#endif // THOR_DIAGNOSTIC_H
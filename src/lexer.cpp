@@ -2,6 +2,8 @@
 #include "string.h"
 
 #include "util/file.h"
+#include "util/simd.h"
+#include "util/thread.h"
 
 namespace Thor {
 
@@ -17,29 +19,197 @@ Maybe<Lexer> Lexer::open(System& sys, StringView filename) {
 	if (length == 0 || length >= 0xff'ff'ff'ff_ulen) {
 		return {};
 	}
-	auto map = file->map(sys.allocator);
-	if (map.is_empty()) {
+	auto map = file->map(sys.allocator, PADDING);
+	if (map.length() != length + PADDING) {
 		return {};
 	}
-	return Lexer{move(map)};
+	return adopt(move(map));
 }
 
-void Lexer::eat() {
-	if (rune_ == '\n') {
-		position_.advance_line();
+Maybe<Lexer> Lexer::create(Array<Uint8>&& source) {
+	const auto length = source.length();
+	if (length == 0 || length >= 0xff'ff'ff'ff_ulen) {
+		return {};
+	}
+	if (!source.resize(length + PADDING)) {
+		return {};
+	}
+	return adopt(move(source));
+}
+
+Maybe<Lexer> Lexer::adopt(Array<Uint8>&& map) {
+	// Validating all of the input up front lets eat() decode without checks and
+	// pure ASCII input skip decoding entirely.
+	const auto input = map.slice().truncate(map.length() - PADDING).cast<const Uint8>();
+	const auto encoding = classify_utf8(input);
+	if (encoding == Encoding::INVALID) {
+		// ERROR: Input is not valid UTF-8
+		return {};
+	}
+	return Lexer{move(map), encoding == Encoding::ASCII};
+}
+
+Bool LineTable::build(StringView input) {
+	const auto data = input.cast<const Uint8>();
+	const auto length = data.length();
+	auto newlines = [&](Ulen offset) {
+		const auto remain = length - offset;
+		const auto block = remain >= SimdBlock::SIZE
+			? SimdBlock::load(data.data() + offset)
+			: SimdBlock::load_partial(data.data() + offset, remain);
+		return block.eq('\n');
+	};
+
+	// Count the lines first so the table is allocated exactly once.
+	Ulen count = 1;
+	for (Ulen offset = 0; offset < length; offset += SimdBlock::SIZE) {
+		count += count_ones64(newlines(offset));
+	}
+
+	if (!starts_.resize(count)) {
+		return false;
+	}
+	Ulen n = 0;
+	starts_[n++] = 0;
+	for (Ulen offset = 0; offset < length; offset += SimdBlock::SIZE) {
+		for (auto mask = newlines(offset); mask; mask &= mask - 1) {
+			starts_[n++] = Uint32(offset + count_trailing_zeros64(mask) + 1);
+		}
+	}
+
+	return true;
+}
+
+Uint32 LineTable::line(Uint32 offset) const {
+	// Find the last line which starts at or before [offset].
+	Ulen lo = 0;
+	Ulen hi = starts_.length();
+	while (hi - lo > 1) {
+		const auto mid = lo + (hi - lo) / 2;
+		if (starts_[mid] <= offset) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
 	}
-	if (position_.next_offset >= input_.length()) {
-		rune_ = 0; // EOF
+	return Uint32(lo);
+}
+
+SourcePosition LineTable::position(Uint32 offset) const {
+	const auto index = line(offset);
+	return SourcePosition { index + 1, offset - starts_[index] + 1 };
+}
+
+const LineTable* Lexer::lines() {
+	if (lines_.is_empty() && !lines_.build(input_)) {
+		return nullptr;
+	}
+	return &lines_;
+}
+
+SourcePosition Lexer::position(Uint32 offset) {
+	if (auto lines = this->lines()) {
+		return lines->position(offset);
+	}
+	return SourcePosition { 0, 0 };
+}
+
+void Lexer::eat() {
+	// Reading one past the end is fine as the input is padded with NUL, which is
+	// EOF. The lexer stays on EOF no matter how many times it is eaten.
+	const auto data = reinterpret_cast<const Uint8*>(input_.data()) + position_.next_offset;
+	const auto lead = data[0];
+	if (lead < 0x80) {
+		if (lead == 0) {
+			// EOF, or Error: Unexpected NUL
+			position_.this_offset = position_.next_offset;
+			rune_ = 0;
+			return;
+		}
+		position_.advance();
+		rune_ = lead;
 		return;
 	}
-	auto rune = input_[position_.next_offset];
-	if (rune == 0) {
-		// Error: Unexpected NUL
-	} else if (rune & 0x80) {
-		// TODO(dweiler): UTF-8
+	// The input was validated when opened so this is a complete and well formed
+	// sequence.
+	if (lead < 0xe0) {
+		rune_ = ((lead & 0x1f_u32) << 6) | (data[1] & 0x3f_u32);
+		position_.advance(2);
+	} else if (lead < 0xf0) {
+		rune_ = ((lead & 0x0f_u32) << 12) | ((data[1] & 0x3f_u32) << 6) | (data[2] & 0x3f_u32);
+		position_.advance(3);
+	} else {
+		rune_ = ((lead & 0x07_u32) << 18) | ((data[1] & 0x3f_u32) << 12)
+		      | ((data[2] & 0x3f_u32) << 6) | (data[3] & 0x3f_u32);
+		position_.advance(4);
+	}
+}
+
+Uint16 Lexer::measure(Uint32 beg) {
+	const auto length = position_.this_offset - beg;
+	if (length < 0xffff_u32) {
+		return static_cast<Uint16>(length);
+	}
+	// Too long for 16 bits. Tokens are lexed in order so the table stays sorted
+	// by offset.
+	if (!overflow_.push_back({ beg, length })) {
+		// ERROR: Out of memory, the token reads back as empty.
+	}
+	return 0;
+}
+
+Uint32 Lexer::overflow(Uint32 offset) const {
+	Ulen lo = 0;
+	Ulen hi = overflow_.length();
+	while (lo < hi) {
+		const auto mid = lo + (hi - lo) / 2;
+		if (overflow_[mid].offset < offset) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo < overflow_.length() && overflow_[lo].offset == offset) {
+		return overflow_[lo].length;
+	}
+	return 0;
+}
+
+// Move to [offset] <= the input length and read the rune there as if everything
+// before it had been eaten.
+void Lexer::seek(Uint32 offset) {
+	position_.next_offset = offset;
+	eat();
+}
+
+void Lexer::classify(Uint32 block) {
+	const auto offset = Ulen(block) * SimdBlock::SIZE;
+	// The last block of the input runs into the padding, the zeros of which
+	// match nothing we search for.
+	const auto v = SimdBlock::load(reinterpret_cast<const Uint8*>(input_.data()) + offset);
+	structure_.white   = v.eq(' ') | v.eq('\t') | v.eq('\r');
+	structure_.newline = v.eq('\n');
+	structure_.quote   = v.eq('"') | v.eq('`');
+	structure_.escape  = v.eq('\\');
+	structure_.comment = v.eq('/') | v.eq('*');
+	block_ = block;
+}
+
+template<typename F>
+Uint32 Lexer::find(Uint32 offset, F&& select) {
+	const auto length = Uint32(input_.length());
+	while (offset < length) {
+		const auto block = offset / SimdBlock::SIZE;
+		if (block != block_) {
+			classify(block);
+		}
+		if (const auto mask = select(structure_) >> (offset % SimdBlock::SIZE)) {
+			const auto found = offset + count_trailing_zeros64(mask);
+			return found < length ? found : length;
+		}
+		offset = (block + 1) * SimdBlock::SIZE;
 	}
-	position_.advance_column();
-	rune_ = rune;
+	return length;
 }
 
 void Lexer::scan_escape() {
@@ -95,23 +265,28 @@ Token Lexer::scan_string() {
 	const auto beg = position_.this_offset;
 	const auto quote = rune_;
 	const auto raw = quote == '`';
+	eat(); // Eat quote
 	for (;;) {
-		if (!raw) {
-			if (rune_ == '\n' || rune_ == 0) {
-				// ERROR: String literal is not terminated.
-				break;
-			}
-		}
-		eat();
+		// Jump to the next character which could end the string.
+		seek(find(position_.this_offset, [raw](const Structure& s) {
+			return raw ? s.quote : s.quote | s.escape | s.newline;
+		}));
 		if (rune_ == quote) {
 			eat(); // Consume quote
 			break;
 		}
-		if (!raw && rune_ == '\\') {
+		if (rune_ == '\n' || rune_ == 0) {
+			// ERROR: String literal is not terminated.
+			break;
+		}
+		if (rune_ == '\\') {
+			eat(); // Eat '\\'
 			scan_escape();
+		} else {
+			eat(); // Eat the other quote character
 		}
 	}
-	return { LiteralKind::STRING, beg, position_.delta(beg) };
+	return { LiteralKind::STRING, beg, measure(beg) };
 }
 
 Token Lexer::scan_number(Bool leading_period) {
@@ -163,8 +338,7 @@ Token Lexer::scan_number(Bool leading_period) {
 		// of the range operators: ..<, ..= permit an integer literal without space
 		// between them. This is the only part of the lexer grammar that appears to
 		// require LR(2).
-		auto peek = position_.this_offset + 1;
-		if (peek < input_.length() && input_[peek] == '.') {
+		if (input_[position_.this_offset + 1] == '.') {
 			return token;
 		}
 		eat(); // Eat '.'
@@ -191,60 +365,310 @@ Token Lexer::scan_number(Bool leading_period) {
 		break;
 	}
 
-	token.length = position_.delta(beg);
+	token.length = measure(beg);
 	return token;
 }
 
-Token Lexer::advance() {
-	// Skip whitespace
-	for (;;) {
-		switch (rune_) {
-		case ' ': case '\t': case '\r':
-			eat(); // Consume
-			continue;
-		case '\n':
-			if (!asi_) {
-				eat();
+// The reserved words are the keywords and the named operators, every other
+// identifier is just an identifier. Rather than compare a scanned identifier
+// against each reserved word we use a minimal perfect hash built at compile
+// time from lexer.inl: the hash picks a bucket, the displacement stored for the
+// bucket picks the only slot the identifier could occupy, and a single compare
+// against that slot settles it.
+struct ReservedWord {
+	StringView match;
+	Token      token = { TokenKind::IDENTIFIER, 0, 0 };
+};
+
+static constexpr const ReservedWord RESERVED_WORDS[] = {
+	#define OPERATOR_true(ENUM, MATCH) \
+		{ MATCH, { OperatorKind::ENUM, 0, 0 } },
+	#define OPERATOR_false(...)
+	#define OPERATOR(ENUM, NAME, MATCH, PREC, NAMED, ASI) \
+		OPERATOR_ ## NAMED (ENUM, MATCH)
+	#define KEYWORD(ENUM, MATCH, ASI) \
+		{ MATCH, { KeywordKind::ENUM, 0, 0 } },
+	#include "lexer.inl"
+	#undef OPERATOR_true
+	#undef OPERATOR_false
+};
+
+struct ReservedTable {
+	static constexpr const Ulen LENGTH  = countof(RESERVED_WORDS);
+	static constexpr const Ulen BUCKETS = 16;
+
+	// The hash only looks at the length and the first and last character, this
+	// is enough to tell the reserved words apart and does not depend on the
+	// length of the identifier. The build below fails to compile if that ever
+	// stops being true.
+	static constexpr Uint32 hash(StringView string) {
+		const auto length = string.length();
+		const auto first = Uint32(Uint8(string[0]));
+		const auto last = Uint32(Uint8(string[length - 1]));
+		return ((first << 16) | (last << 8) | Uint32(length & 0xff)) * 0x9e3779b1_u32;
+	}
+	static constexpr Uint32 bucket(Uint32 hash) {
+		return hash >> 28;
+	}
+	static constexpr Uint32 slot(Uint32 hash, Uint16 displace) {
+		const auto mixed = (hash ^ (Uint32(displace) * 0x85ebca6b_u32)) * 0xc2b2ae35_u32;
+		return Uint32((Uint64(mixed) * LENGTH) >> 32);
+	}
+
+	Uint16       displace[BUCKETS] = {};
+	ReservedWord words[LENGTH]     = {};
+	Ulen         min_length        = ~0_ulen;
+	Ulen         max_length        = 0;
+	Bool         valid             = false;
+};
+static_assert(ReservedTable::BUCKETS <= 16, "Bucket is selected with the top four bits of the hash");
+
+static constexpr ReservedTable build_reserved_table() {
+	ReservedTable table;
+	constexpr const auto LENGTH = ReservedTable::LENGTH;
+	constexpr const auto BUCKETS = ReservedTable::BUCKETS;
+
+	Uint32 hashes[LENGTH] = {};
+	Ulen counts[BUCKETS] = {};
+	for (Ulen i = 0; i < LENGTH; i++) {
+		const auto& match = RESERVED_WORDS[i].match;
+		hashes[i] = ReservedTable::hash(match);
+		counts[ReservedTable::bucket(hashes[i])]++;
+		if (match.length() < table.min_length) table.min_length = match.length();
+		if (match.length() > table.max_length) table.max_length = match.length();
+	}
+
+	// Place the largest buckets first while the table is still mostly empty.
+	Ulen order[BUCKETS] = {};
+	for (Ulen i = 0; i < BUCKETS; i++) {
+		order[i] = i;
+	}
+	for (Ulen i = 0; i < BUCKETS; i++) {
+		for (Ulen j = i + 1; j < BUCKETS; j++) {
+			if (counts[order[j]] > counts[order[i]]) {
+				const auto tmp = order[i];
+				order[i] = order[j];
+				order[j] = tmp;
+			}
+		}
+	}
+
+	Bool used[LENGTH] = {};
+	for (Ulen b = 0; b < BUCKETS; b++) {
+		const auto bucket = order[b];
+		if (counts[bucket] == 0) {
+			break;
+		}
+		Bool placed = false;
+		for (Uint32 displace = 0; displace <= 0xffff && !placed; displace++) {
+			Ulen slots[LENGTH] = {};
+			Ulen n_slots = 0;
+			placed = true;
+			for (Ulen i = 0; i < LENGTH && placed; i++) {
+				if (ReservedTable::bucket(hashes[i]) != bucket) {
+					continue;
+				}
+				const auto slot = ReservedTable::slot(hashes[i], displace);
+				if (used[slot]) {
+					placed = false;
+				}
+				for (Ulen j = 0; j < n_slots; j++) {
+					if (slots[j] == slot) {
+						placed = false;
+					}
+				}
+				slots[n_slots++] = slot;
+			}
+			if (!placed) {
 				continue;
 			}
+			table.displace[bucket] = Uint16(displace);
+			for (Ulen i = 0; i < LENGTH; i++) {
+				if (ReservedTable::bucket(hashes[i]) == bucket) {
+					const auto slot = ReservedTable::slot(hashes[i], displace);
+					used[slot] = true;
+					table.words[slot] = RESERVED_WORDS[i];
+				}
+			}
+		}
+		if (!placed) {
+			return table;
 		}
-		break;
 	}
-	const auto beg = position_.this_offset;
-	if (rune_.is_char()) {
-		while (rune_.is_alpha()) eat();
-		const auto len = position_.delta(beg);
-		const auto str = input_.slice(beg).truncate(len);
-		static constexpr const struct {
-			StringView   match;
-			OperatorKind kind;
-		} OPERATORS[] = {
-			#define OPERATOR_true(ENUM, MATCH) \
-				{ MATCH, OperatorKind::ENUM },
-			#define OPERATOR_false(...)
-			#define OPERATOR(ENUM, NAME, MATCH, PREC, NAMED, ASI) \
-				OPERATOR_ ## NAMED (ENUM, MATCH)
-			#include "lexer.inl"
-		};
-		for (Ulen i = 0; i < countof(OPERATORS); i++) {
-			if (const auto& op = OPERATORS[i]; op.match == str) {
-				return { op.kind, beg, len };
+
+	table.valid = true;
+	return table;
+}
+
+static constexpr const auto RESERVED_TABLE = build_reserved_table();
+static_assert(RESERVED_TABLE.valid, "Could not build a perfect hash of the reserved words");
+
+// Which bytes are ASCII runes that can continue an identifier.
+static constexpr const auto IDENTIFIER = [] {
+	struct { Bool v[256] = {}; constexpr Bool operator[](Uint8 i) const { return v[i]; } } table;
+	for (Ulen i = 0; i < 256; i++) {
+		table.v[i] = i == '_'
+		          || (i >= 'a' && i <= 'z')
+		          || (i >= 'A' && i <= 'Z')
+		          || (i >= '0' && i <= '9');
+	}
+	return table;
+}();
+
+Token Lexer::identifier(StringView string, Uint32 offset, Uint16 length) {
+	const auto n = string.length();
+	if (n >= RESERVED_TABLE.min_length && n <= RESERVED_TABLE.max_length) {
+		const auto hash = ReservedTable::hash(string);
+		const auto bucket = ReservedTable::bucket(hash);
+		const auto slot = ReservedTable::slot(hash, RESERVED_TABLE.displace[bucket]);
+		if (const auto& word = RESERVED_TABLE.words[slot]; word.match == string) {
+			auto token = word.token;
+			token.offset = offset;
+			token.length = length;
+			return token;
+		}
+	}
+	return { TokenKind::IDENTIFIER, offset, length };
+}
+
+// Every token spelled with symbols rather than letters: the assignments, the
+// operators which are not named, and the punctuation token kinds. Note '--' is
+// not here, it is not an operator in Odin and lexes as two '-'.
+struct Punctuation {
+	StringView match;
+	Token      token;
+};
+
+static constexpr const Punctuation PUNCTUATION[] = {
+	#define ASSIGN(ENUM, NAME, MATCH) \
+		{ MATCH, { AssignKind::ENUM, 0, 0 } },
+	#define OPERATOR_true(...)
+	#define OPERATOR_false(ENUM, MATCH) \
+		{ MATCH, { OperatorKind::ENUM, 0, 0 } },
+	#define OPERATOR(ENUM, NAME, MATCH, PREC, NAMED, ASI) \
+		OPERATOR_ ## NAMED (ENUM, MATCH)
+	#include "lexer.inl"
+	#undef OPERATOR_true
+	#undef OPERATOR_false
+	{ "@",   { TokenKind::ATTRIBUTE,    0, 0 } },
+	{ "#",   { TokenKind::DIRECTIVE,    0, 0 } },
+	{ "$",   { TokenKind::CONST,        0, 0 } },
+	{ ";",   { TokenKind::EXPLICITSEMI, 0, 0 } },
+	{ ",",   { TokenKind::COMMA,        0, 0 } },
+	{ "{",   { TokenKind::LBRACE,       0, 0 } },
+	{ "}",   { TokenKind::RBRACE,       0, 0 } },
+	{ "---", { TokenKind::UNDEFINED,    0, 0 } },
+};
+
+// A DFA over the punctuation built at compile time. The states are the nodes of
+// a trie of the matches and bytes are first mapped to a small class so the
+// transition table stays a couple of KiB. Every byte which is not punctuation,
+// including the NUL padding, is class zero which leads to the dead state, so a
+// walk always stops on its own.
+struct PunctuationTable {
+	static constexpr const Ulen  STATES  = 64;
+	static constexpr const Ulen  CLASSES = 32;
+	static constexpr const Uint8 DEAD    = 0;
+	static constexpr const Uint8 START   = 1;
+
+	struct Accept {
+		// The token matched on reaching the state, with the length of the match,
+		// or INVALID when the state is only a prefix of longer matches.
+		Token token = { TokenKind::INVALID, 0, 0 };
+	};
+
+	Uint8  classes[256]          = {};
+	Uint8  next[STATES][CLASSES] = {};
+	Accept accept[STATES]        = {};
+	Bool   valid                 = false;
+};
+
+static constexpr PunctuationTable build_punctuation_table() {
+	PunctuationTable table;
+	Ulen classes = 1; // Class zero is everything which is not punctuation
+	Ulen states = PunctuationTable::START + 1;
+	for (const auto& punctuation : PUNCTUATION) {
+		Ulen state = PunctuationTable::START;
+		for (auto ch : punctuation.match) {
+			auto& cls = table.classes[Uint8(ch)];
+			if (cls == 0) {
+				if (classes == PunctuationTable::CLASSES) {
+					return table;
+				}
+				cls = Uint8(classes++);
 			}
+			auto& next = table.next[state][cls];
+			if (next == PunctuationTable::DEAD) {
+				if (states == PunctuationTable::STATES) {
+					return table;
+				}
+				next = Uint8(states++);
+			}
+			state = next;
+		}
+		auto& accept = table.accept[state].token;
+		if (accept.kind != TokenKind::INVALID) {
+			// The same match is listed twice.
+			return table;
+		}
+		accept = punctuation.token;
+		accept.length = Uint16(punctuation.match.length());
+	}
+	table.valid = true;
+	return table;
+}
+
+static constexpr const auto PUNCTUATION_TABLE = build_punctuation_table();
+static_assert(PUNCTUATION_TABLE.valid, "Could not build the punctuation DFA");
+
+Token Lexer::punctuation(StringView input, Uint32 offset) {
+	// Walk until the dead state remembering the last accepting state passed
+	// through, which is the longest match.
+	Token token = { TokenKind::INVALID, offset, 0 };
+	Ulen state = PunctuationTable::START;
+	for (auto i = offset; ; i++) {
+		const auto cls = PUNCTUATION_TABLE.classes[Uint8(input[i])];
+		state = PUNCTUATION_TABLE.next[state][cls];
+		if (state == PunctuationTable::DEAD) {
+			break;
+		}
+		if (const auto& accept = PUNCTUATION_TABLE.accept[state].token; accept.kind != TokenKind::INVALID) {
+			token = accept;
+		}
+	}
+	token.offset = offset;
+	return token;
+}
+
+Token Lexer::advance() {
+	// Skip whitespace
+	switch (rune_) {
+	case '\n':
+		if (asi_) {
+			break;
 		}
-		static constexpr const struct {
-			StringView  match;
-			KeywordKind kind;
-		} KEYWORDS[] = {
-			#define KEYWORD(ENUM, MATCH, ASI) \
-				{ MATCH, KeywordKind::ENUM },
-			#include "lexer.inl"
-		};
-		for (Ulen i = 0; i < countof(KEYWORDS); i++) {
-			if (const auto& kw = KEYWORDS[i]; kw.match == str) {
-				return { kw.kind, beg, len };
+		[[fallthrough]];
+	case ' ': case '\t': case '\r':
+		// Newlines are only whitespace when they cannot insert a semicolon.
+		seek(find(position_.this_offset, [asi = asi_](const Structure& s) {
+			return ~(asi ? s.white : s.white | s.newline);
+		}));
+	}
+	const auto beg = position_.this_offset;
+	if (rune_.is_char()) {
+		for (;;) {
+			// ASCII runes are a byte each so skip over them without decoding.
+			auto offset = position_.next_offset;
+			while (IDENTIFIER[Uint8(input_[offset])]) offset++;
+			seek(offset);
+			// Anything else can only continue the identifier when not ASCII.
+			if (ascii_ || !rune_.is_alpha()) {
+				break;
 			}
+			eat();
 		}
-		return { TokenKind::IDENTIFIER, beg, len };
+		const auto string = input_.slice(beg).truncate(position_.this_offset - beg);
+		return identifier(string, beg, measure(beg));
 	}
 	switch (rune_) {
 	case '0': case '1': case '2': case '3': case '4':
@@ -269,225 +693,79 @@ Token Lexer::advance() {
 		eat();
 		asi_ = false;
 		return next(); // Recurse
-	case '@': eat(); return { TokenKind::ATTRIBUTE,    beg, 1_u16 };
-	case '#': eat(); return { TokenKind::DIRECTIVE,    beg, 1_u16 };
-	case '$': eat(); return { TokenKind::CONST,        beg, 1_u16 };
-	case ';': eat(); return { TokenKind::EXPLICITSEMI, beg, 1_u16 };
-	case ',': eat(); return { TokenKind::COMMA,        beg, 1_u16 };
-	case '{': eat(); return { TokenKind::LBRACE,       beg, 1_u16 };
-	case '}': eat(); return { TokenKind::RBRACE,       beg, 1_u16 };
-	case '(': eat(); return { OperatorKind::LPAREN,    beg, 1_u16 };
-	case ')': eat(); return { OperatorKind::RPAREN,    beg, 1_u16 };
-	case '[': eat(); return { OperatorKind::LBRACKET,  beg, 1_u16 };
-	case ']': eat(); return { OperatorKind::RBRACKET,  beg, 1_u16 };
-	case '?': eat(); return { OperatorKind::QUESTION,  beg, 1_u16 };
-	case ':': eat(); return { OperatorKind::COLON,     beg, 1_u16 };
-	case '^': eat(); return { OperatorKind::POINTER,   beg, 1_u16 };
-	case '%':
-		eat(); // Eat '%'
-		switch (rune_) {
-		case '=':
-			eat(); // Eat '='
-			return { AssignKind::MOD, beg, 2_u16 };
-		case '%':
-			eat(); // Eat '%'
-			if (rune_ == '=') {
-				eat(); // Eat '='
-				return { AssignKind::MOD, beg, 3_u16 };
-			}
-			return { OperatorKind::MOD, beg, 2_u16 };
-		}
-		return { OperatorKind::MOD, beg, 1_u16 };
-	case '*':
-		eat(); // Eat '*'
-		if (rune_ == '=') {
-			return { AssignKind::MUL, beg, 2_u16 };
-		}
-		return { OperatorKind::MUL, beg, 1_u16 };
-	case '/':
-		eat(); // Eat '/'
-		switch (rune_) {
-		case '/':
-			// Scan to EOL or EOF
-			eat(); // Eat '/'
-			while (rune_ != '\n' && rune_ != 0) eat();
-			eat(); // Eat '\n'
-			return { TokenKind::COMMENT, beg, position_.delta(beg) }; // '//'
-		case '*':
-			eat(); // Eat '*'
-			for (Ulen i = 1; i != 0; /**/) switch (rune_) {
-			case 0:
-				// EOF
-				i = 0;
-				break;
-			case '/':
-				eat(); // Eat '/'
-				if (rune_ == '*') {
-					eat(); // Eat '*'
-					i++;
-				}
-				break;
-			case '*':
-				eat(); // Eat '*'
-				if (rune_ == '/') {
-					eat(); // Eat '/'
-					i--;
-				}
-				break;
-			default:
-				eat(); // Eat what ever is in the comment
-				break;
-			}
-			// This also limits comments to no more than 64 KiB
-			return { TokenKind::COMMENT, beg, position_.delta(beg) }; // '/*'
-		case '=':
-			eat(); // '='
-			return { AssignKind::QUO, beg, 2_u16 }; // '/='
-		}
-		return { OperatorKind::QUO, beg, 1_u16 }; // '/'
-	case '~':
-		eat(); // Eat '~'
-		if (rune_ == '=') {
-			eat(); // Eat '='
-			return { AssignKind::XOR, beg, 2_u16 };
-		}
-		return { OperatorKind::XOR, beg, 1_u16 };
-	case '!':
-		eat(); // Eat '!'
-		if (rune_ == '=') {
-			eat(); // Eat '='
-			return { OperatorKind::NEQ, beg, 2_u16 };
-		}
-		return { OperatorKind::LNOT, beg, 1_u16 };
-	case '+':
-		eat(); // Eat '+'
-		if (rune_ == '=') {
-			eat(); // Eat '='
-			return { AssignKind::ADD, beg, 2_u16 };
-		}
-		return { OperatorKind::ADD, beg, 1_u16 };
-	case '-':
-		eat(); // Eat '-'
-		switch (rune_) {
-		case '=':
-			eat(); // Eat '='
-			return { AssignKind::SUB, beg, 2_u16 };
-		case '>':
-			eat(); // Eat '>'
-			return { OperatorKind::ARROW, beg, 2_u16 };
-		case '-':
-			eat(); // Eat '-'
-			if (rune_ == '-') {
-				return { TokenKind::UNDEFINED, beg, 3_u16 };
-			} else {
-				// ERROR: Decrement operator '--' isn't allowed in Odin
-			}
-		}
-		return { OperatorKind::SUB, beg, 1_u16 };
-	case '=':
-		eat(); // Eat '='
-		if (rune_ == '=') {
-			return { OperatorKind::EQ, beg, 2_u16 };
-		}
-		return { AssignKind::EQ, beg, 1_u16 };
 	case '.':
-		eat(); // Eat '.'
-		switch (rune_) {
-		case '.':
-			eat(); // Eat '.'
-			switch (rune_) {
-			case '<': // ..<
-				eat(); // Eat '<'
-				return { OperatorKind::RANGEHALF, beg, position_.delta(beg) }; // '..<'
-			case '=': // ..=
-				eat(); // Eat '='
-				return { OperatorKind::RANGEFULL, beg, position_.delta(beg) }; // '..='
-			}
-			return { OperatorKind::ELLIPSIS, beg, 2_u16 }; // '..'
+		// A period followed by a digit is a float like '.5'
+		switch (input_[position_.next_offset]) {
 		case '0': case '1': case '2': case '3': case '4':
 		case '5': case '6': case '7': case '8': case '9':
+			eat(); // Eat '.'
 			return scan_number(true);
 		}
-		return { OperatorKind::PERIOD, beg, 1_u16 }; // '.'
-	case '<':
-		eat(); // Eat '<'
-		switch (rune_) {
-		case '=':
-			eat(); // Eat '='
-			return { OperatorKind::LT, beg, 2_u16 }; // '<='
-		case '<':
-			eat(); // Eat '<'
-			if (rune_ == '=') {
-				eat(); // Eat '='
-				return { AssignKind::SHL, beg, 3_u16 }; // '<<'
-			}
-			return { OperatorKind::SHL, beg, 2_u16 }; // '<<='
-		}
-		return { OperatorKind::LT, beg, 1_u16 }; // '<'
-	case '>':
-		eat(); // Eat '>'
-		switch (rune_) {
-		case '=':
-			eat(); // Eat '='
-			return { OperatorKind::GT, beg, 2_u16 }; // '>='
-		case '>':
-			eat(); // Eat '>'
-			if (rune_ == '=') {
-				eat(); // Eat '='
-				return { AssignKind::SHR, beg, 3_u16 }; // '>>'
-			}
-			return { OperatorKind::SHR, beg, 2_u16 }; // '>>='
-		}
-		return { OperatorKind::GT, beg, 1_u16 }; // '>'
-	case '&':
-		eat(); // Eat '&'
-		switch (rune_) {
-		case '~':
-			eat(); // Eat '~'
-			if (rune_ == '=') {
-				eat(); // Eat '='
-				return { AssignKind::ANDNOT, beg, 3_u16 }; // '&~='
-			}
-			return { OperatorKind::ANDNOT, beg, 2_u16 }; // '&~'
-		case '=':
-			eat(); // Eat '='
-			return { AssignKind::BAND, beg, 2_u16 }; // '&='
-		case '&':
-			eat(); // Eat '&'
-			if (rune_ == '=') {
-				eat(); // Eat '='
-				return { AssignKind::LAND, beg, 3_u16 }; // '&&='
-			}
-			return { OperatorKind::LAND, beg, 2_u16 }; // '&&'
-		}
-		return { OperatorKind::BAND, beg, 1_u16 };
-	case '|':
-		eat(); // Eat '|'
-		switch (rune_) {
-		case '=':
-			eat(); // Eat '='
-			return { AssignKind::BOR, beg, 2_u16 }; // '|='
-		case '|':
-			eat(); // Eat '|'
-			if (rune_ == '=') {
-				eat(); // Eat '='
-				return { AssignKind::LOR, beg, 3_u16 }; // '||='
-			}
-			return { OperatorKind::LOR, beg, 2_u16 }; // '|='
+		break;
+	case '/':
+		switch (input_[position_.next_offset]) {
+		case '/': case '*':
+			scan_comment();
+			return { TokenKind::COMMENT, beg, measure(beg) };
 		}
-		return { OperatorKind::BOR, beg, 1_u16 }; // '|'
+		break;
 	case '`':
 		[[fallthrough]];
 	case '"':
 		return scan_string();
-	default:
+	}
+	// Everything else is punctuation or not a token at all.
+	const auto token = punctuation(input_, beg);
+	if (token.kind == TokenKind::INVALID) {
 		eat();
 		return { TokenKind::INVALID, beg, 1_u16 };
 	}
-	return { TokenKind::ENDOF, beg, 1_u16 };
+	seek(beg + token.length);
+	return token;
 }
 
-Token Lexer::next() {
+void Lexer::scan_comment() {
+	eat(); // Eat '/'
+	if (rune_ == '/') {
+		// Scan to EOL or EOF. The newline is not part of the comment, it may still
+		// insert a semicolon.
+		eat(); // Eat '/'
+		seek(find(position_.this_offset, [](const Structure& s) {
+			return s.newline;
+		}));
+		return;
+	}
+	eat(); // Eat '*'
+	for (Ulen i = 1; i != 0; /**/) {
+		// Jump to the next '/' or '*' as nothing else can open or close a comment.
+		seek(find(position_.this_offset, [](const Structure& s) {
+			return s.comment;
+		}));
+		switch (rune_) {
+		case 0:
+			// EOF
+			i = 0;
+			break;
+		case '/':
+			eat(); // Eat '/'
+			if (rune_ == '*') {
+				eat(); // Eat '*'
+				i++;
+			}
+			break;
+		case '*':
+			eat(); // Eat '*'
+			if (rune_ == '/') {
+				eat(); // Eat '/'
+				i--;
+			}
+			break;
+		}
+	}
+}
+
+// Can a newline after [token] insert a semicolon?
+static Bool inserts_semicolon(Token token) {
 	static constexpr const Bool KIND_ASI[] = {
 		#define KIND(ENUM, NAME, ASI) ASI,
 		#include "lexer.inl"
@@ -500,21 +778,522 @@ Token Lexer::next() {
 		#define KEYWORD(ENUM, MATCH, ASI) ASI,
 		#include "lexer.inl"
 	};
-	const auto token = advance();
-	Bool asi = false;
 	switch (token.kind) {
 	case TokenKind::OPERATOR:
-		asi = OPERATOR_ASI[Uint32(token.as_operator)];
-		break;
+		return OPERATOR_ASI[Uint32(token.as_operator)];
 	case TokenKind::KEYWORD:
-		asi = KEYWORD_ASI[Uint32(token.as_keyword)];
-		break;
+		return KEYWORD_ASI[Uint32(token.as_keyword)];
 	default:
-		asi = KIND_ASI[Uint32(token.kind)];
-		break;
+		return KIND_ASI[Uint32(token.kind)];
+	}
+}
+
+Token Lexer::next() {
+	const auto token = advance();
+	// Comments leave semicolon insertion as it was, e.g. the newline after a
+	// comment trailing a statement still ends it.
+	if (token.kind != TokenKind::COMMENT) {
+		asi_ = inserts_semicolon(token);
 	}
-	asi_ = asi;
 	return token;
 }
 
-} // namespace Thor
\ No newline at end of file
+// The sub-kind of [token] as a byte, zero for kinds which do not have one.
+static Uint8 sub_kind(Token token) {
+	switch (token.kind) {
+	case TokenKind::ASSIGNMENT: return Uint8(token.as_assign);
+	case TokenKind::LITERAL:    return Uint8(token.as_literal);
+	case TokenKind::OPERATOR:   return Uint8(token.as_operator);
+	case TokenKind::KEYWORD:    return Uint8(token.as_keyword);
+	case TokenKind::DIRECTIVE:  return Uint8(token.as_directive);
+	default:
+		return 0;
+	}
+}
+
+Bool Token::operator==(const Token& other) const {
+	return kind == other.kind
+	    && offset == other.offset
+	    && length == other.length
+	    && sub_kind(*this) == sub_kind(other);
+}
+
+Maybe<TokenStream> Lexer::tokenize_all(Allocator& allocator) {
+	TokenStream stream{allocator};
+	// Source averages a token every handful of bytes, reserving up front avoids
+	// most of the regrowth of the arrays.
+	if (!stream.reserve(input_.length() / 4)) {
+		return {};
+	}
+	for (;;) {
+		const auto token = next();
+		if (!stream.push(token)) {
+			return {};
+		}
+		if (token.kind == TokenKind::ENDOF) {
+			break;
+		}
+	}
+	return stream;
+}
+
+Maybe<TokenStream> Lexer::tokenize_parallel(System& sys, Allocator& allocator, Ulen threads) {
+	const auto beg = position_.this_offset;
+	const auto length = Uint32(input_.length());
+
+	// Not worth splitting the input into chunks smaller than this.
+	static constexpr const Uint32 MIN_CHUNK = 256 * 1024;
+	if (threads > (length - beg) / MIN_CHUNK) {
+		threads = (length - beg) / MIN_CHUNK;
+	}
+	if (threads <= 1) {
+		return tokenize_all(allocator);
+	}
+
+	// Each chunk lexes the tokens which begin inside of it on a lexer of its own
+	// and then one more token, which begins in the next chunk. The lexer is kept
+	// around so the stitching below can carry on lexing from where it stopped.
+	struct Chunk {
+		Chunk(System& sys, StringView input, Bool ascii, Uint32 beg, Uint32 end, Bool last)
+			: system{sys}
+			, temporary{system}
+			, lexer{temporary, input, ascii}
+			, tokens{temporary}
+			, next{TokenKind::ENDOF, end, 0}
+			, beg{beg}
+			, end{end}
+			, last{last}
+		{
+		}
+		static void run(System&, void* user) {
+			static_cast<Chunk*>(user)->lex();
+		}
+		void lex() {
+			if (!tokens.reserve((end - beg) / 4)) {
+				ok = false;
+				return;
+			}
+			lexer.seek(beg);
+			for (;;) {
+				const auto token = lexer.next();
+				if (!last && token.offset >= end) {
+					next = token;
+					return;
+				}
+				if (!tokens.push_back(token)) {
+					ok = false;
+					return;
+				}
+				if (token.kind == TokenKind::ENDOF) {
+					return;
+				}
+			}
+		}
+		SystemAllocator    system;
+		TemporaryAllocator temporary;
+		Lexer              lexer;
+		Array<Token>       tokens;
+		Token              next;
+		Uint32             beg;
+		Uint32             end;
+		Bool               last;
+		Bool               ok = true;
+		Maybe<Thread>      thread;
+	};
+
+	// Chunks begin at the start of a line. A new line is the likeliest place for
+	// the lexer to be outside of any token with no semicolon pending.
+	Array<Uint32> bounds{allocator};
+	if (!bounds.push_back(beg)) {
+		return {};
+	}
+	for (Ulen i = 1; i < threads; i++) {
+		auto offset = Uint32(beg + Uint64(length - beg) * i / threads);
+		if (offset <= bounds.last()) {
+			continue;
+		}
+		while (offset < length && input_[offset - 1] != '\n') {
+			offset++;
+		}
+		if (offset < length && offset > bounds.last() && !bounds.push_back(offset)) {
+			return {};
+		}
+	}
+	if (!bounds.push_back(length)) {
+		return {};
+	}
+
+	const auto n_chunks = bounds.length() - 1;
+	Array<Chunk*> chunks{allocator};
+	auto destroy = [&] {
+		for (auto chunk : chunks) {
+			allocator.destroy(chunk); // Joins the thread
+		}
+	};
+	for (Ulen i = 0; i < n_chunks; i++) {
+		const auto last = i == n_chunks - 1;
+		auto chunk = allocator.create<Chunk>(sys, input_, ascii_, bounds[i], bounds[i + 1], last);
+		if (!chunk || !chunks.push_back(chunk)) {
+			allocator.destroy(chunk);
+			destroy();
+			return {};
+		}
+	}
+
+	// The first chunk carries on from the state of this lexer and is lexed on
+	// this thread. The others are lexed with no semicolon pending.
+	chunks[0]->lexer.asi_ = asi_;
+	for (Ulen i = 1; i < n_chunks; i++) {
+		auto chunk = chunks[i];
+		chunk->thread = Thread::start(sys, Chunk::run, chunk);
+		if (!chunk->thread) {
+			chunk->lex();
+		}
+	}
+	chunks[0]->lex();
+	for (auto chunk : chunks) {
+		if (chunk->thread) {
+			chunk->thread->join();
+		}
+	}
+
+	for (auto chunk : chunks) {
+		if (!chunk->ok) {
+			destroy();
+			return {};
+		}
+	}
+
+	TokenStream stream{allocator};
+	if (!stream.reserve(length / 4)) {
+		destroy();
+		return {};
+	}
+
+	// The first chunk started in the correct state so all of it is correct. From
+	// then on we hold a lexer which is known to be in the correct state and the
+	// next token it produced, which is yet to be added to the stream.
+	// Tokens too long for Token::length were recorded by the lexer of the chunk,
+	// carry them over to this one.
+	auto push = [&](const Lexer& from, Token token) {
+		if (token.length == 0 && !overflow_.push_back({ token.offset, from.length(token) })) {
+			return false;
+		}
+		return stream.push(token);
+	};
+	Bool ok = true;
+	for (const auto token : chunks[0]->tokens) {
+		ok = ok && push(chunks[0]->lexer, token);
+	}
+	Bool done = !chunks[0]->tokens.is_empty()
+	         && chunks[0]->tokens.last().kind == TokenKind::ENDOF;
+	auto lexer = &chunks[0]->lexer;
+	auto token = chunks[0]->next;
+	for (Ulen i = 1; i < n_chunks && ok && !done; i++) {
+		auto& chunk = *chunks[i];
+		const auto& speculative = chunk.tokens;
+		Ulen j = 0;
+		for (;;) {
+			if (!chunk.last && token.offset >= chunk.end) {
+				// The correct lexer has run past this chunk entirely, e.g. a
+				// comment spanning all of it.
+				break;
+			}
+			// The lexer is a function of the offset and whether a semicolon may be
+			// inserted, and the latter is decided by the last token. So when the
+			// speculative lexer produces the same token as the correct one at the
+			// same offset, everything it produced after that is correct as well.
+			// Comments do not count as they leave semicolon insertion as it was.
+			while (j < speculative.length() && speculative[j].offset < token.offset) {
+				j++;
+			}
+			if (token.kind != TokenKind::COMMENT
+			    && j < speculative.length()
+			    && speculative[j] == token)
+			{
+				for (; j < speculative.length(); j++) {
+					ok = ok && push(chunk.lexer, speculative[j]);
+				}
+				// A NUL inside of the input ends it early.
+				done = speculative.last().kind == TokenKind::ENDOF;
+				lexer = &chunk.lexer;
+				token = chunk.next;
+				break;
+			}
+			ok = ok && push(*lexer, token);
+			if (!ok || token.kind == TokenKind::ENDOF) {
+				done = true;
+				break;
+			}
+			token = lexer->next();
+		}
+	}
+
+	destroy();
+	if (!ok) {
+		return {};
+	}
+	return stream;
+}
+
+Bool Lexer::relex(TokenStream& stream, const TextEdit& edit) {
+	const auto size = Uint32(input_.length());
+	if (stream.is_empty() || edit.offset > size || edit.removed > size - edit.offset) {
+		return false;
+	}
+	// Both ends of the edit have to be on a rune boundary, the padding after the
+	// input is one.
+	auto boundary = [&](Uint32 offset) {
+		return (Uint8(input_[offset]) & 0xc0) != 0x80;
+	};
+	const auto inserted = edit.inserted.cast<const Uint8>();
+	const auto encoding = classify_utf8(inserted);
+	if (encoding == Encoding::INVALID || !boundary(edit.offset) || !boundary(edit.offset + edit.removed)) {
+		// ERROR: Edit is not valid UTF-8
+		return false;
+	}
+	const auto edited = Ulen(size) - edit.removed + inserted.length();
+	if (edited == 0 || edited >= 0xff'ff'ff'ff_ulen) {
+		return false;
+	}
+
+	// The input is edited in place, keeping the removed bytes to undo the edit
+	// should anything after it fail.
+	auto& allocator = map_.allocator();
+	Array<Uint8> removed{allocator};
+	if (!removed.resize(edit.removed) || !map_.reserve(edited + PADDING)) {
+		return false;
+	}
+	if (edit.removed != 0) {
+		memcpy(removed.data(), input_.data() + edit.offset, edit.removed);
+	}
+	auto replace = [&](Uint32 offset, Ulen length, Slice<const Uint8> bytes) {
+		const auto tail = input_.length() - offset - length;
+		const auto grown = input_.length() - length + bytes.length();
+		if (grown > input_.length() && !map_.resize(grown + PADDING)) {
+			return; // Cannot happen, there is room reserved
+		}
+		memmove(map_.data() + offset + bytes.length(), map_.data() + offset + length, tail + PADDING);
+		if (!bytes.is_empty()) {
+			memcpy(map_.data() + offset, bytes.data(), bytes.length());
+		}
+		if (grown < input_.length() && !map_.resize(grown + PADDING)) {
+			return; // Cannot happen, the array shrinks
+		}
+		input_ = map_.slice().truncate(grown).cast<const char>();
+		block_ = NO_BLOCK;
+	};
+	auto undo = [&] {
+		replace(edit.offset, inserted.length(), removed.slice().cast<const Uint8>());
+		return false;
+	};
+	replace(edit.offset, edit.removed, inserted);
+
+	// Tokens after the edit move by this much, which wraps around when the edit
+	// shrinks the input. The edit ends at [end] in the edited input.
+	const auto delta = Uint32(inserted.length()) - edit.removed;
+	const auto end = edit.offset + Uint32(inserted.length());
+
+	// Deciding where a token ends looks at most this many bytes past its end: the
+	// rune after an identifier, two bytes after a number or punctuation.
+	static constexpr const Uint32 LOOKAHEAD = 4;
+
+	// Find the first token which the edit could have changed. The lexer is in the
+	// same state after the token before it as it was before the edit: at the end
+	// of that token with semicolon insertion decided by it.
+	const auto offsets = stream.offsets();
+	Ulen lo = 0;
+	Ulen hi = stream.length();
+	while (lo < hi) {
+		const auto mid = lo + (hi - lo) / 2;
+		if (Uint64(offsets[mid]) + length(stream[mid]) + LOOKAHEAD <= edit.offset) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	const auto first = lo;
+	Uint32 restart = 0;
+	Bool asi = false;
+	if (first != 0) {
+		const auto token = stream[first - 1];
+		restart = token.offset + length(token);
+		asi = inserts_semicolon(token);
+	}
+
+	Lexer lexer{allocator, input_, ascii_ && encoding == Encoding::ASCII};
+	lexer.asi_ = asi;
+	lexer.seek(restart);
+
+	// Lex until a token past the edit is the token of [stream] at the same
+	// shifted offset. Like when stitching chunks in tokenize_parallel() the lexer
+	// is then in the same state as it was after that token, so the rest of the
+	// tokens are those of [stream]. Comments do not count as they leave semicolon
+	// insertion as it was.
+	Array<Token> tokens{allocator};
+	Ulen tail = stream.length();
+	Uint32 resync = 0xffffffff_u32; // Offset of that token before the edit
+	for (Ulen j = first; /**/; /**/) {
+		const auto token = lexer.next();
+		if (token.kind != TokenKind::COMMENT && token.offset >= end) {
+			while (j < stream.length() && offsets[j] < token.offset - delta) {
+				j++;
+			}
+			if (j < stream.length()) {
+				auto old = stream[j];
+				const auto old_length = length(old);
+				old.offset += delta;
+				if (old == token && old_length == lexer.length(token)) {
+					tail = j;
+					resync = offsets[j];
+					break;
+				}
+			}
+		}
+		if (!tokens.push_back(token)) {
+			return undo();
+		}
+		if (token.kind == TokenKind::ENDOF) {
+			break;
+		}
+	}
+
+	// The lengths of long tokens are kept the same way: those before the restart,
+	// those found by the lexer, then those after the token it stopped at, moved.
+	Bool ok = true;
+	Array<Overflow> overflow{overflow_.allocator()};
+	for (const auto& entry : overflow_) {
+		if (entry.offset < restart) {
+			ok = ok && overflow.push_back(entry);
+		}
+	}
+	for (const auto& entry : lexer.overflow_) {
+		ok = ok && overflow.push_back(entry);
+	}
+	for (const auto& entry : overflow_) {
+		if (entry.offset > resync) {
+			ok = ok && overflow.push_back({ entry.offset + delta, entry.length });
+		}
+	}
+	if (!ok || !stream.splice(first, tail, restart, resync, tokens.slice().cast<const Token>(), delta)) {
+		return undo();
+	}
+
+	// Nothing can fail from here on.
+	ascii_ = lexer.ascii_;
+	overflow_ = move(overflow);
+	lines_.clear();
+	seek(Uint32(edited));
+	asi_ = false;
+	return true;
+}
+
+Bool TokenStream::reserve(Ulen length) {
+	return kinds_.reserve(length)
+	    && subs_.reserve(length)
+	    && offsets_.reserve(length)
+	    && lengths_.reserve(length);
+}
+
+Bool TokenStream::push(Token token) {
+	if (token.kind == TokenKind::COMMENT) {
+		return comments_.push_back(token);
+	}
+	return kinds_.push_back(token.kind)
+	    && subs_.push_back(sub_kind(token))
+	    && offsets_.push_back(token.offset)
+	    && lengths_.push_back(token.length);
+}
+
+// Replace the elements in [beg, end) of [array] with [count] elements to be
+// filled in after. There must be room reserved for them.
+template<typename T>
+static void replace(Array<T>& array, Ulen beg, Ulen end, Ulen count, T fill) {
+	const auto length = array.length();
+	const auto resized = length - (end - beg) + count;
+	for (auto i = length; i < resized; i++) {
+		if (!array.push_back(fill)) {
+			return; // Cannot happen, there is room reserved
+		}
+	}
+	memmove(array.data() + beg + count, array.data() + end, (length - end) * sizeof(T));
+	for (auto i = resized; i < length; i++) {
+		array.pop_back();
+	}
+}
+
+Bool TokenStream::splice(Ulen beg, Ulen end, Uint32 from, Uint32 to, Slice<const Token> tokens, Uint32 delta) {
+	// The comments in [from, to), which are ordered by offset like the tokens.
+	auto find = [&](Uint32 offset) {
+		Ulen lo = 0;
+		Ulen hi = comments_.length();
+		while (lo < hi) {
+			const auto mid = lo + (hi - lo) / 2;
+			if (comments_[mid].offset < offset) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		return lo;
+	};
+	const auto comments_beg = find(from);
+	const auto comments_end = find(to);
+
+	Ulen n_comments = 0;
+	for (const auto token : tokens) {
+		n_comments += token.kind == TokenKind::COMMENT;
+	}
+	const auto n_tokens = tokens.length() - n_comments;
+
+	// Reserve everything up front so the stream is either changed entirely or
+	// not at all.
+	const auto length = kinds_.length() - (end - beg) + n_tokens;
+	if (!reserve(length) || !comments_.reserve(comments_.length() - (comments_end - comments_beg) + n_comments)) {
+		return false;
+	}
+	replace(kinds_, beg, end, n_tokens, TokenKind::INVALID);
+	replace(subs_, beg, end, n_tokens, Uint8(0));
+	replace(offsets_, beg, end, n_tokens, 0_u32);
+	replace(lengths_, beg, end, n_tokens, 0_u16);
+	replace(comments_, comments_beg, comments_end, n_comments, Token{TokenKind::COMMENT, 0, 0});
+
+	Ulen i = beg;
+	Ulen j = comments_beg;
+	for (const auto token : tokens) {
+		if (token.kind == TokenKind::COMMENT) {
+			comments_[j++] = token;
+		} else {
+			kinds_[i] = token.kind;
+			subs_[i] = sub_kind(token);
+			offsets_[i] = token.offset;
+			lengths_[i] = token.length;
+			i++;
+		}
+	}
+	for (; i < length; i++) {
+		offsets_[i] += delta;
+	}
+	for (; j < comments_.length(); j++) {
+		comments_[j].offset += delta;
+	}
+	return true;
+}
+
+Token TokenStream::operator[](Ulen index) const {
+	const auto kind = kinds_[index];
+	const auto sub = subs_[index];
+	const auto offset = offsets_[index];
+	const auto length = lengths_[index];
+	switch (kind) {
+	case TokenKind::ASSIGNMENT: return { AssignKind(sub),    offset, length };
+	case TokenKind::LITERAL:    return { LiteralKind(sub),   offset, length };
+	case TokenKind::OPERATOR:   return { OperatorKind(sub),  offset, length };
+	case TokenKind::KEYWORD:    return { KeywordKind(sub),   offset, length };
+	case TokenKind::DIRECTIVE:  return { DirectiveKind(sub), offset, length };
+	default:
+		return { kind, offset, length };
+	}
+}
+
+} // namespace Thor
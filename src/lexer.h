@@ -82,100 +82,260 @@ struct Token {
 		as_directive = kind;
 	}
 	void dump(System& sys, StringView input);
+	Bool operator==(const Token& other) const;
 	TokenKind kind; // 1b
 	union {
-		Nat           as_nat{};
+		Uint8         as_raw{}; // Zero for kinds without a sub-kind
 		AssignKind    as_assign;
 		LiteralKind   as_literal;
 		OperatorKind  as_operator;
 		KeywordKind   as_keyword;
 		DirectiveKind as_directive;
 	};              // 1b
-	Uint16 length;  // 2b (if 0, length is too long and must be re-lexed at the given offset)
+	Uint16 length;  // 2b (if 0, length is too long and is kept by Lexer::length)
 	Uint32 offset;  // 4b
 };
 static_assert(sizeof(Token) == 8, "Token cannot be larger than 64-bits");
 
 struct Allocator;
 
+// The tokens of a whole input held as parallel arrays of kind, sub-kind, offset
+// and length rather than as an array of Token. A pass which only cares about
+// token kinds, like finding matching braces, only has to touch the kinds.
+// Comments are kept out of the stream in a side table of their own so consumers
+// never have to step over them.
+struct TokenStream {
+	TokenStream(Allocator& allocator)
+		: kinds_{allocator}
+		, subs_{allocator}
+		, offsets_{allocator}
+		, lengths_{allocator}
+		, comments_{allocator}
+	{
+	}
+	TokenStream(TokenStream&&) = default;
+
+	[[nodiscard]] Bool reserve(Ulen length);
+	[[nodiscard]] Bool push(Token token);
+	// Replace the tokens in [beg, end) and the comments at offsets in [from, to)
+	// with [tokens], then move the offsets of everything after them by [delta].
+	// Nothing changes when out of memory.
+	[[nodiscard]] Bool splice(Ulen beg, Ulen end, Uint32 from, Uint32 to, Slice<const Token> tokens, Uint32 delta);
+
+	Token operator[](Ulen index) const;
+
+	THOR_FORCEINLINE constexpr Ulen length() const { return kinds_.length(); }
+	THOR_FORCEINLINE constexpr Bool is_empty() const { return kinds_.is_empty(); }
+
+	THOR_FORCEINLINE Slice<const TokenKind> kinds() const { return kinds_.slice(); }
+	THOR_FORCEINLINE Slice<const Uint8> subs() const { return subs_.slice(); }
+	THOR_FORCEINLINE Slice<const Uint32> offsets() const { return offsets_.slice(); }
+	THOR_FORCEINLINE Slice<const Uint16> lengths() const { return lengths_.slice(); }
+	THOR_FORCEINLINE Slice<const Token> comments() const { return comments_.slice(); }
+
+private:
+	Array<TokenKind> kinds_;
+	Array<Uint8>     subs_;
+	Array<Uint32>    offsets_;
+	Array<Uint16>    lengths_;
+	Array<Token>     comments_;
+};
+
 struct Position {
-	Uint32 line        = 0;
-	Uint32 column      = 0;
 	Uint32 next_offset = 0;
 	Uint32 this_offset = 0;
-	void advance_column() {
+	void advance(Uint32 n = 1) {
 		this_offset = next_offset;
-		next_offset++;
-		column++;
+		next_offset += n;
 	}
-	void advance_line() {
-		line++;
-		column = 0;
+};
+
+// Line and column, both counted from one. Columns count bytes.
+struct SourcePosition {
+	Uint32 line   = 0;
+	Uint32 column = 0;
+};
+
+// Offset of the first byte of every line of some input. The table is counted out
+// with SIMD and answers position queries with a binary search, so reporting a
+// diagnostic does not rescan the input.
+struct LineTable {
+	constexpr LineTable(Allocator& allocator)
+		: starts_{allocator}
+	{
 	}
-	Uint16 delta(Uint32 beg) const {
-		const auto diff = this_offset - beg;
-		if (diff >= 0xffff_u16) {
-			// Too large to fit in 16-bits.
-			return 0;
-		}
-		return static_cast<Uint16>(diff);
+	LineTable(LineTable&& other)
+		: starts_{move(other.starts_)}
+	{
+	}
+	// Build the table for [input], replacing what was there before.
+	[[nodiscard]] Bool build(StringView input);
+	// Index of the line containing [offset], counted from zero.
+	Uint32 line(Uint32 offset) const;
+	SourcePosition position(Uint32 offset) const;
+	THOR_FORCEINLINE Slice<const Uint32> starts() const {
+		return starts_.slice();
+	}
+	THOR_FORCEINLINE constexpr Bool is_empty() const {
+		return starts_.is_empty();
 	}
+	// Forget the table, e.g. when the input changes.
+	void clear() {
+		starts_.clear();
+	}
+private:
+	Array<Uint32> starts_;
+};
+
+// An edit of some input: [removed] bytes at [offset] replaced with [inserted].
+struct TextEdit {
+	Uint32     offset;
+	Uint32     removed;
+	StringView inserted;
 };
 
 struct Lexer {
+	// The input is always followed by this many zero bytes. The lexer treats NUL
+	// as the end of the input so it never has to check the offset against the
+	// length, and vector loads of a block of input may read past the end.
+	static constexpr const Ulen PADDING = 64;
+
 	static Maybe<Lexer> open(System& sys, StringView file);
+	// Lex [source] which is already in memory, it gets padded.
+	static Maybe<Lexer> create(Array<Uint8>&& source);
 	Lexer(Lexer&& other)
 		: map_{move(other.map_)}
 		, input_{other.input_}
 		, position_{other.position_}
 		, rune_{exchange(other.rune_, 0)}
 		, asi_{exchange(other.asi_, false)}
+		, ascii_{other.ascii_}
+		, block_{exchange(other.block_, NO_BLOCK)}
+		, structure_{other.structure_}
+		, lines_{move(other.lines_)}
+		, overflow_{move(other.overflow_)}
 	{
 	}
 	Token next();
 	void eat();
+
+	// Lex everything from the current position to the end of the input in one
+	// go. The stream always ends with an ENDOF token.
+	Maybe<TokenStream> tokenize_all(Allocator& allocator);
+
+	// Same as tokenize_all() but splits the input into up to [threads] chunks
+	// at line starts and lexes each one speculatively on its own thread. The
+	// chunks are stitched back together afterwards, relexing from the end of the
+	// previous chunk wherever a chunk began in the middle of a comment or string
+	// or with a pending semicolon, until the speculative tokens agree again. The
+	// result is identical to tokenize_all().
+	Maybe<TokenStream> tokenize_parallel(System& sys, Allocator& allocator, Ulen threads);
+
+	// Apply [edit] to the input and update [stream], the tokens of all of the
+	// input, to match. Lexing restarts after the last token the edit cannot have
+	// changed and stops once it produces a token of [stream] again past the edit.
+	// The tokens from there on are kept and only have their offsets moved, so the
+	// lexing done is proportional to the size of the edit rather than the input.
+	// The stream ends up identical to what tokenize_all() gives for the edited
+	// input, and the lexer is left at the end of it. On failure, like an edit out
+	// of range or one which is not valid UTF-8, neither is changed.
+	[[nodiscard]] Bool relex(TokenStream& stream, const TextEdit& edit);
+
 	THOR_FORCEINLINE constexpr StringView input() const {
 		return input_;
 	}
-	THOR_FORCEINLINE constexpr StringView string(Token token) const {
-		return input_.slice(token.offset).truncate(token.length);
+	THOR_FORCEINLINE StringView string(Token token) const {
+		return input_.slice(token.offset).truncate(length(token));
 	}
 
-	// Calculate the source position for a given token.
-	struct SourcePosition {
-		Uint32 line   = 0;
-		Uint32 column = 0;
-	};
-	SourcePosition position(Uint32 offset) const {
-		Uint32 line   = 1;
-		Uint32 column = 1;
-		for (Uint32 i = 0; i < offset; i++) {
-			if (input_[i] == '\n') {
-				column = 1;
-				line++;
-			} else {
-				column++;
-			}
-		}
-		return SourcePosition { line, column };
+	// The length of [token], including tokens too long for Token::length.
+	THOR_FORCEINLINE Uint32 length(Token token) const {
+		return token.length ? token.length : overflow(token.offset);
 	}
 
+	// Classify the identifier [string] at [offset] as a keyword, named operator
+	// or plain identifier.
+	static Token identifier(StringView string, Uint32 offset, Uint16 length);
+
+	// The longest operator, assignment or other punctuation at [offset] of the
+	// padded [input]. This is an INVALID token of length zero when there is none.
+	static Token punctuation(StringView input, Uint32 offset);
+
+	// Calculate the source position for a given offset. The line table this
+	// needs is built on first use.
+	SourcePosition position(Uint32 offset);
+
+	// The start offset of every line, or nullptr when out of memory.
+	const LineTable* lines();
+
 private:
+	// Structural masks for one 64-byte block of input, bit N is set when byte N
+	// of the block is one of the listed characters. These let the lexer jump
+	// over runs of whitespace, comment bodies and string bodies in one step
+	// instead of eating them a byte at a time.
+	struct Structure {
+		Uint64 white   = 0; // ' ', '\t', '\r'
+		Uint64 newline = 0; // '\n'
+		Uint64 quote   = 0; // '"', '`'
+		Uint64 escape  = 0; // '\\'
+		Uint64 comment = 0; // '/', '*'
+	};
+	static constexpr const Uint32 NO_BLOCK = 0xffffffff_u32;
+
+	// Find the first offset at or after [offset] whose bit is set in the mask
+	// produced by [select], or the length of the input when there is none.
+	template<typename F>
+	Uint32 find(Uint32 offset, F&& select);
+	void classify(Uint32 block);
+	void seek(Uint32 offset);
+
+	// Length of the token from [beg] to the current position for Token::length.
+	// Lengths which do not fit in 16 bits are recorded in overflow_ and give 0.
+	Uint16 measure(Uint32 beg);
+	Uint32 overflow(Uint32 offset) const;
+
 	Token advance();
+	void scan_comment();
 	Token scan_string();
 	void scan_escape();
 	Token scan_number(Bool leading_period);
-	Lexer(Array<Uint8>&& map)
+	// Take the already padded [map] if it is valid UTF-8.
+	static Maybe<Lexer> adopt(Array<Uint8>&& map);
+	Lexer(Array<Uint8>&& map, Bool ascii)
 		: map_{move(map)}
-		, input_{map_.slice().cast<const char>()}
+		, input_{map_.slice().truncate(map_.length() - PADDING).cast<const char>()}
+		, ascii_{ascii}
+		, lines_{map_.allocator()}
+		, overflow_{map_.allocator()}
 	{
 		eat();
 	}
+	// A lexer over the padded [input] of another lexer, which found it to be pure
+	// [ascii] or not. It must be positioned with seek() before use.
+	Lexer(Allocator& allocator, StringView input, Bool ascii)
+		: map_{allocator}
+		, input_{input}
+		, ascii_{ascii}
+		, lines_{allocator}
+		, overflow_{allocator}
+	{
+	}
 	Array<Uint8> map_;
 	StringView   input_;
 	Position     position_;
 	Rune         rune_ = 0;
 	Bool         asi_  = false;
+	Bool         ascii_ = false; // Every rune is a single byte
+	Uint32       block_ = NO_BLOCK; // Index of the block held in structure_
+	Structure    structure_;
+	LineTable    lines_;
+
+	// Tokens too long for Token::length, ordered by offset.
+	struct Overflow {
+		Uint32 offset;
+		Uint32 length;
+	};
+	Array<Overflow> overflow_;
 };
 
 } // namespace Thor
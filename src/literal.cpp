@@ -0,0 +1,714 @@
+#include "util/simd.h"
+
+#include "literal.h"
+
+#if defined(THOR_COMPILER_MSVC)
+#include <intrin.h>
+#endif
+
+namespace Thor {
+
+// Unsigned integer of [N] 32-bit limbs, least significant first. Only has what
+// is needed to build the power of five table at compile time and to compare a
+// decimal against a binary value exactly when the fast paths cannot decide. It
+// is never large enough to overflow for the values it is used with.
+template<Ulen N>
+struct BigUint {
+	constexpr BigUint(Uint32 value = 0) {
+		limbs_[0] = value;
+	}
+	constexpr void mul(Uint32 value) {
+		Uint64 carry = 0;
+		for (Ulen i = 0; i < N; i++) {
+			const auto product = Uint64(limbs_[i]) * value + carry;
+			limbs_[i] = Uint32(product);
+			carry = product >> 32;
+		}
+	}
+	constexpr void add(Uint32 value) {
+		Uint64 carry = value;
+		for (Ulen i = 0; i < N && carry; i++) {
+			const auto sum = Uint64(limbs_[i]) + carry;
+			limbs_[i] = Uint32(sum);
+			carry = sum >> 32;
+		}
+	}
+	constexpr void div(Uint32 value) {
+		Uint64 remainder = 0;
+		for (Ulen i = N; i-- > 0; /**/) {
+			const auto current = (remainder << 32) | limbs_[i];
+			limbs_[i] = Uint32(current / value);
+			remainder = current % value;
+		}
+	}
+	constexpr void shl(Ulen bits) {
+		const auto limbs = bits / 32;
+		const auto shift = bits % 32;
+		for (Ulen i = N; i-- > 0; /**/) {
+			Uint64 value = 0;
+			if (i >= limbs) {
+				value = Uint64(limbs_[i - limbs]) << shift;
+				if (shift && i > limbs) {
+					value |= limbs_[i - limbs - 1] >> (32 - shift);
+				}
+			}
+			limbs_[i] = Uint32(value);
+		}
+	}
+	// Multiply by 5^[power].
+	constexpr void pow5(Ulen power) {
+		for (; power >= 13; power -= 13) {
+			mul(1220703125_u32); // 5^13
+		}
+		Uint32 value = 1;
+		for (; power; power--) {
+			value *= 5;
+		}
+		mul(value);
+	}
+	// Number of bits needed to represent the value.
+	constexpr Sint64 width() const {
+		for (Ulen i = N; i-- > 0; /**/) {
+			if (const auto limb = limbs_[i]) {
+				Sint64 bits = i * 32;
+				for (auto v = limb; v; v >>= 1) {
+					bits++;
+				}
+				return bits;
+			}
+		}
+		return 0;
+	}
+	constexpr Bool bit(Sint64 index) const {
+		if (index < 0 || index >= Sint64(N * 32)) {
+			return false;
+		}
+		return (limbs_[index / 32] >> (index % 32)) & 1;
+	}
+	// The 64 bits starting at bit [index], where bits below zero read as zero.
+	constexpr Uint64 window(Sint64 index) const {
+		Uint64 result = 0;
+		for (Sint64 i = 0; i < 64; i++) {
+			result |= Uint64(bit(index + i)) << i;
+		}
+		return result;
+	}
+	// Are all of the bits in [lo, hi) set.
+	constexpr Bool ones(Sint64 lo, Sint64 hi) const {
+		for (Sint64 i = lo; i < hi; i++) {
+			if (!bit(i)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	constexpr Sint32 compare(const BigUint& other) const {
+		for (Ulen i = N; i-- > 0; /**/) {
+			if (limbs_[i] != other.limbs_[i]) {
+				return limbs_[i] < other.limbs_[i] ? -1 : 1;
+			}
+		}
+		return 0;
+	}
+private:
+	Uint32 limbs_[N] = {};
+};
+
+// 5^q for every q in [SMALLEST_POWER, LARGEST_POWER] as the 128 most significant
+// bits. Positive powers are truncated and negative powers are rounded up, which
+// is what the Eisel-Lemire algorithm expects. Outside of this range a decimal of
+// 19 digits is always zero or infinity.
+static constexpr const Sint32 SMALLEST_POWER = -342;
+static constexpr const Sint32 LARGEST_POWER  = 308;
+
+struct PowerOfFive {
+	Uint64 hi = 0;
+	Uint64 lo = 0;
+};
+
+struct PowerTable {
+	PowerOfFive powers[LARGEST_POWER - SMALLEST_POWER + 1];
+};
+
+static constexpr PowerTable build_power_table() {
+	PowerTable table;
+
+	BigUint<24> power{1};
+	for (Sint32 q = 0; q <= LARGEST_POWER; q++) {
+		const auto width = power.width();
+		table.powers[q - SMALLEST_POWER] = { power.window(width - 64), power.window(width - 128) };
+		power.mul(5);
+	}
+
+	// The negative powers are floor(2^b / 5^n) + 1 where b is picked so there are
+	// at least 128 bits. Dividing 2^B for a large enough B by five repeatedly
+	// gives floor(2^B / 5^n) exactly, the quotient for the smaller b is the same
+	// number with the low B - b bits dropped.
+	constexpr const Sint64 B = 1791;
+	BigUint<56> reciprocal{1};
+	reciprocal.shl(B);
+	BigUint<26> five{1};
+	for (Sint32 n = 1; n <= -SMALLEST_POWER; n++) {
+		reciprocal.div(5);
+		five.mul(5);
+		const auto z = five.width(); // 2^z > 5^n
+		const auto b = n <= 27 ? z + 127 : 2 * z + 128;
+		const auto width = reciprocal.width();
+		auto hi = reciprocal.window(width - 64);
+		auto lo = reciprocal.window(width - 128);
+		// Adding one only reaches the top 128 bits when every bit below them is set.
+		if (reciprocal.ones(B - b, width - 128) && ++lo == 0 && ++hi == 0) {
+			hi = 1_u64 << 63;
+		}
+		table.powers[-n - SMALLEST_POWER] = { hi, lo };
+	}
+
+	return table;
+}
+
+static constexpr const PowerTable POWERS = build_power_table();
+
+struct Uint128 {
+	Uint64 lo;
+	Uint64 hi;
+};
+
+static THOR_FORCEINLINE Uint128 multiply(Uint64 lhs, Uint64 rhs) {
+#if defined(THOR_COMPILER_MSVC)
+	return { lhs * rhs, __umulh(lhs, rhs) };
+#else
+	const auto product = static_cast<unsigned __int128>(lhs) * rhs;
+	return { Uint64(product), Uint64(product >> 64) };
+#endif
+}
+
+// The exponent and mantissa fields of a Float64.
+struct Binary {
+	Uint64 mantissa = 0;
+	Sint32 exponent = 0;
+	constexpr Bool operator==(const Binary&) const = default;
+	Float64 value() const {
+		return __builtin_bit_cast(Float64, mantissa | (Uint64(exponent) << 52));
+	}
+};
+
+static constexpr const Sint32 INFINITE_EXPONENT = 0x7ff;
+
+// Round [w] * 10^[q] to the nearest Float64 with the Eisel-Lemire algorithm. The
+// result is always correct as long as [w] is exact.
+static Binary eisel_lemire(Sint64 q, Uint64 w) {
+	if (w == 0 || q < SMALLEST_POWER) {
+		return { 0, 0 };
+	}
+	if (q > LARGEST_POWER) {
+		return { 0, INFINITE_EXPONENT };
+	}
+	const auto lz = Sint32(count_leading_zeros64(w));
+	w <<= lz;
+
+	// The 64-bit product with the truncated power is almost always enough to
+	// determine the 55 bits we need, only when all the bits below them are set
+	// could the rest of the power carry into them.
+	const auto& power = POWERS.powers[q - SMALLEST_POWER];
+	auto product = multiply(w, power.hi);
+	static constexpr const Uint64 PRECISION_MASK = 0xffff'ffff'ffff'ffff_u64 >> 55;
+	if ((product.hi & PRECISION_MASK) == PRECISION_MASK) {
+		const auto second = multiply(w, power.lo);
+		product.lo += second.hi;
+		if (second.hi > product.lo) {
+			product.hi++;
+		}
+	}
+
+	const auto upper = Sint32(product.hi >> 63);
+	const auto shift = upper + 64 - 52 - 3;
+	Binary result;
+	result.mantissa = product.hi >> shift;
+	// floor(log2(10^q)) + 63 computed in fixed point.
+	result.exponent = Sint32(((Sint64(152170 + 65536) * q) >> 16) + 63) + upper - lz + 1023;
+
+	if (result.exponent <= 0) {
+		// Subnormal, or zero when all of the bits would be shifted out.
+		if (-result.exponent + 1 >= 64) {
+			return { 0, 0 };
+		}
+		result.mantissa >>= -result.exponent + 1;
+		result.mantissa += result.mantissa & 1;
+		result.mantissa >>= 1;
+		// Rounding up may have made it a normal number after all.
+		result.exponent = result.mantissa < (1_u64 << 52) ? 0 : 1;
+		result.mantissa &= ~(1_u64 << 52);
+		return result;
+	}
+
+	// Exactly halfway between two values, which can only happen for small powers,
+	// rounds to even rather than up.
+	if (product.lo <= 1 && q >= -4 && q <= 23 && (result.mantissa & 3) == 1) {
+		if ((result.mantissa << shift) == product.hi) {
+			result.mantissa &= ~1_u64;
+		}
+	}
+	result.mantissa += result.mantissa & 1;
+	result.mantissa >>= 1;
+	if (result.mantissa >= (2_u64 << 52)) {
+		result.mantissa = 1_u64 << 52;
+		result.exponent++;
+	}
+	result.mantissa &= ~(1_u64 << 52);
+	if (result.exponent >= INFINITE_EXPONENT) {
+		return { 0, INFINITE_EXPONENT };
+	}
+	return result;
+}
+
+static THOR_FORCEINLINE Uint32 digit_value(char ch) {
+	if (ch >= '0' && ch <= '9') return ch - '0';
+	if (ch >= 'a' && ch <= 'z') return ch - 'a' + 10;
+	if (ch >= 'A' && ch <= 'Z') return ch - 'A' + 10;
+	return 36;
+}
+
+// Eight ASCII digits are checked and converted at once in a 64-bit register.
+static THOR_FORCEINLINE Uint64 load_eight_digits(const char* data) {
+	Uint64 value = 0;
+	for (Ulen i = 0; i < 8; i++) {
+		value |= Uint64(Uint8(data[i])) << (i * 8);
+	}
+	return value;
+}
+
+static THOR_FORCEINLINE Bool is_eight_digits(Uint64 value) {
+	return ((value & 0xf0f0'f0f0'f0f0'f0f0_u64)
+	     | (((value + 0x0606'0606'0606'0606_u64) & 0xf0f0'f0f0'f0f0'f0f0_u64) >> 4))
+	    == 0x3333'3333'3333'3333_u64;
+}
+
+static THOR_FORCEINLINE Uint64 parse_eight_digits(Uint64 value) {
+	static constexpr const Uint64 MASK = 0x0000'00ff'0000'00ff_u64;
+	static constexpr const Uint64 MUL1 = 100 + (1000000_u64 << 32);
+	static constexpr const Uint64 MUL2 = 1 + (10000_u64 << 32);
+	value -= 0x3030'3030'3030'3030_u64;
+	value = (value * 10) + (value >> 8);
+	return (((value & MASK) * MUL1) + (((value >> 16) & MASK) * MUL2)) >> 32;
+}
+
+Maybe<Uint64> LiteralTable::decode_integer(StringView string) {
+	const auto length = string.length();
+	Uint32 base = 10;
+	Ulen i = 0;
+	if (length >= 2 && string[0] == '0') {
+		switch (string[1]) {
+		case 'b': base = 2;  i = 2; break;
+		case 'o': base = 8;  i = 2; break;
+		case 'd': base = 10; i = 2; break;
+		case 'z': base = 12; i = 2; break;
+		case 'x': base = 16; i = 2; break;
+		case 'h': base = 16; i = 2; break;
+		}
+	}
+	static constexpr const Uint64 MAX = 0xffff'ffff'ffff'ffff_u64;
+	Uint64 value = 0;
+	Ulen digits = 0;
+	while (i < length) {
+		// Runs of eight decimal digits which cannot overflow.
+		if (base == 10 && i + 8 <= length && value <= (MAX - 99999999) / 100000000) {
+			const auto eight = load_eight_digits(string.data() + i);
+			if (is_eight_digits(eight)) {
+				value = value * 100000000 + parse_eight_digits(eight);
+				digits += 8;
+				i += 8;
+				continue;
+			}
+		}
+		const auto ch = string[i++];
+		if (ch == '_') {
+			continue;
+		}
+		const auto digit = digit_value(ch);
+		if (digit >= base || value > (MAX - digit) / base) {
+			// Digit out of range for the base or too large for 64 bits.
+			return {};
+		}
+		value = value * base + digit;
+		digits++;
+	}
+	if (digits == 0) {
+		return {};
+	}
+	return value;
+}
+
+// A decimal as the first 19 significant digits and a power of ten.
+struct Decimal {
+	Uint64 mantissa  = 0;
+	Sint64 exponent  = 0;
+	Uint32 digits    = 0;     // Significant digits in the mantissa
+	Bool   truncated = false; // Nonzero digits did not fit in the mantissa
+};
+
+static constexpr const Uint32 MAX_DIGITS = 19;
+
+static Maybe<Decimal> parse_decimal(StringView string) {
+	const auto length = string.length();
+	Decimal decimal;
+	Ulen i = 0;
+	Ulen seen = 0;
+	auto put = [&](Uint32 digit, Bool fraction) {
+		seen++;
+		if (decimal.digits == 0 && digit == 0) {
+			// Leading zeros are not significant.
+			decimal.exponent -= fraction;
+		} else if (decimal.digits < MAX_DIGITS) {
+			decimal.mantissa = decimal.mantissa * 10 + digit;
+			decimal.digits++;
+			decimal.exponent -= fraction;
+		} else {
+			decimal.truncated |= digit != 0;
+			decimal.exponent += !fraction;
+		}
+	};
+	auto digits = [&](Bool fraction) {
+		while (i < length) {
+			if (decimal.digits != 0 && decimal.digits + 8 <= MAX_DIGITS && i + 8 <= length) {
+				const auto eight = load_eight_digits(string.data() + i);
+				if (is_eight_digits(eight)) {
+					decimal.mantissa = decimal.mantissa * 100000000 + parse_eight_digits(eight);
+					decimal.digits += 8;
+					decimal.exponent -= fraction ? 8 : 0;
+					seen += 8;
+					i += 8;
+					continue;
+				}
+			}
+			const auto ch = string[i];
+			if (ch >= '0' && ch <= '9') {
+				put(ch - '0', fraction);
+			} else if (ch != '_') {
+				break;
+			}
+			i++;
+		}
+	};
+
+	digits(false);
+	if (i < length && string[i] == '.') {
+		i++;
+		digits(true);
+	}
+	if (seen == 0) {
+		return {};
+	}
+	if (i < length && (string[i] == 'e' || string[i] == 'E')) {
+		i++;
+		Bool negative = false;
+		if (i < length && (string[i] == '+' || string[i] == '-')) {
+			negative = string[i++] == '-';
+		}
+		Sint64 exponent = 0;
+		Ulen exponent_digits = 0;
+		for (; i < length; i++) {
+			const auto ch = string[i];
+			if (ch >= '0' && ch <= '9') {
+				// Anything this large is zero or infinity already.
+				if (exponent < 0x10000) {
+					exponent = exponent * 10 + (ch - '0');
+				}
+				exponent_digits++;
+			} else if (ch != '_') {
+				break;
+			}
+		}
+		if (exponent_digits == 0) {
+			return {};
+		}
+		decimal.exponent += negative ? -exponent : exponent;
+	}
+	if (i != length) {
+		return {};
+	}
+	return decimal;
+}
+
+// When the decimal had more digits than fit in 64 bits and the digits dropped
+// decide the rounding, compare the decimal exactly against the point halfway
+// between [lower] and the Float64 after it.
+static Binary round_exactly(StringView string, const Decimal& decimal, Binary lower) {
+	static constexpr const Ulen LIMIT = 768; // Enough to decide any halfway case
+	BigUint<192> lhs;
+	Ulen taken = 0;
+	Bool sticky = false;
+	for (const auto ch : string) {
+		if (ch == 'e' || ch == 'E') {
+			break;
+		} else if (ch < '0' || ch > '9' || (taken == 0 && ch == '0')) {
+			continue;
+		} else if (taken < LIMIT) {
+			lhs.mul(10);
+			lhs.add(ch - '0');
+			taken++;
+		} else {
+			sticky |= ch != '0';
+		}
+	}
+	// The digits taken are scaled by this power of ten.
+	const auto e10 = decimal.exponent + Sint64(decimal.digits) - Sint64(taken);
+
+	auto mantissa = lower.mantissa;
+	Sint64 e2 = -1074;
+	if (lower.exponent != 0) {
+		mantissa |= 1_u64 << 52;
+		e2 = lower.exponent - 1075;
+	}
+	// The halfway point is (2 * mantissa + 1) * 2^(e2 - 1).
+	BigUint<192> rhs{Uint32(mantissa >> 31)};
+	rhs.shl(32);
+	rhs.add(Uint32(((mantissa << 1) | 1) & 0xffff'ffff_u64));
+	if (e10 >= 0) {
+		lhs.pow5(e10);
+	} else {
+		rhs.pow5(-e10);
+	}
+	const auto shift = e10 - (e2 - 1);
+	if (shift >= 0) {
+		lhs.shl(shift);
+	} else {
+		rhs.shl(-shift);
+	}
+
+	auto compare = lhs.compare(rhs);
+	if (compare == 0 && sticky) {
+		compare = 1;
+	}
+	if (compare > 0 || (compare == 0 && (mantissa & 1))) {
+		// The next Float64 up, which carries into the exponent as needed.
+		const auto bits = (lower.mantissa | (Uint64(lower.exponent) << 52)) + 1;
+		return { bits & ((1_u64 << 52) - 1), Sint32(bits >> 52) };
+	}
+	return lower;
+}
+
+Maybe<Float64> LiteralTable::decode_float(StringView string) {
+	auto decimal = parse_decimal(string);
+	if (!decimal) {
+		return {};
+	}
+	const auto w = decimal->mantissa;
+	const auto q = decimal->exponent;
+
+	// Both the mantissa and the power of ten are exact as Float64 so a single
+	// multiplication or division is correctly rounded.
+	static constexpr const Float64 EXACT[] = {
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+	if (!decimal->truncated && w <= (1_u64 << 53) && q >= -22 && q <= 22) {
+		return q < 0 ? Float64(w) / EXACT[-q] : Float64(w) * EXACT[q];
+	}
+
+	auto result = eisel_lemire(q, w);
+	if (decimal->truncated && !(eisel_lemire(q, w + 1) == result)) {
+		result = round_exactly(string, *decimal, result);
+	}
+	return result.value();
+}
+
+Maybe<Float64> LiteralTable::decode_imaginary(StringView string) {
+	if (string.is_empty()) {
+		return {};
+	}
+	string = string.truncate(string.length() - 1); // Remove 'i', 'j' or 'k'
+	if (string.length() >= 2 && string[0] == '0' && digit_value(string[1]) >= 10) {
+		if (auto value = decode_integer(string)) {
+			return Float64(*value);
+		}
+		return {};
+	}
+	return decode_float(string);
+}
+
+// Encode [rune] as UTF-8.
+static Bool put_utf8(Array<char>& result, Uint32 rune) {
+	if (rune < 0x80) {
+		return result.push_back(char(rune));
+	} else if (rune < 0x800) {
+		return result.push_back(char(0xc0 | (rune >> 6)))
+		    && result.push_back(char(0x80 | (rune & 0x3f)));
+	} else if (rune < 0x10000) {
+		return result.push_back(char(0xe0 | (rune >> 12)))
+		    && result.push_back(char(0x80 | ((rune >> 6) & 0x3f)))
+		    && result.push_back(char(0x80 | (rune & 0x3f)));
+	}
+	return result.push_back(char(0xf0 | (rune >> 18)))
+	    && result.push_back(char(0x80 | ((rune >> 12) & 0x3f)))
+	    && result.push_back(char(0x80 | ((rune >> 6) & 0x3f)))
+	    && result.push_back(char(0x80 | (rune & 0x3f)));
+}
+
+Bool LiteralTable::decode_string(StringView string, Array<char>& result) {
+	result.clear();
+	if (string.length() < 2 || string[string.length() - 1] != string[0]) {
+		// ERROR: String literal is not terminated.
+		return false;
+	}
+	const auto raw = string[0] == '`';
+	string = string.slice(1).truncate(string.length() - 2);
+	for (Ulen i = 0; i < string.length(); /**/) {
+		const auto ch = string[i++];
+		if (raw || ch != '\\') {
+			if (!result.push_back(ch)) {
+				return false;
+			}
+			continue;
+		}
+		if (i == string.length()) {
+			// The closing quote was escaped so the string is not terminated.
+			return false;
+		}
+		const auto escape = string[i++];
+		Uint32 base = 16;
+		Ulen digits = 0;
+		char value = 0;
+		switch (escape) {
+		case 'a':  value = '\a'; break;
+		case 'b':  value = '\b'; break;
+		case 'e':  value = '\x1b'; break;
+		case 'f':  value = '\f'; break;
+		case 'n':  value = '\n'; break;
+		case 'r':  value = '\r'; break;
+		case 't':  value = '\t'; break;
+		case 'v':  value = '\v'; break;
+		case '\\':
+		case '\'':
+		case '"':
+			value = escape;
+			break;
+		case '0': case '1': case '2': case '3':
+		case '4': case '5': case '6': case '7':
+			i--; // The first digit is part of the value
+			base = 8;
+			digits = 3;
+			break;
+		case 'x': digits = 2; break;
+		case 'u': digits = 4; break;
+		case 'U': digits = 8; break;
+		default:
+			// ERROR: Unknown escape sequence in string
+			return false;
+		}
+		if (digits == 0) {
+			if (!result.push_back(value)) {
+				return false;
+			}
+			continue;
+		}
+		if (i + digits > string.length()) {
+			// ERROR: Unterminated escape sequence
+			return false;
+		}
+		Uint32 rune = 0;
+		for (Ulen j = 0; j < digits; j++) {
+			const auto digit = digit_value(string[i++]);
+			if (digit >= base) {
+				// ERROR: Unknown character in escape sequence
+				return false;
+			}
+			rune = rune * base + digit;
+		}
+		if (escape == 'u' || escape == 'U') {
+			if (rune > 0x10ffff || (rune >= 0xd800 && rune <= 0xdfff)) {
+				// ERROR: Invalid code point in escape sequence
+				return false;
+			}
+			if (!put_utf8(result, rune)) {
+				return false;
+			}
+		} else if (rune > 0xff || !result.push_back(char(rune))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+Bool LiteralTable::build(const Lexer& lexer, const TokenStream& tokens) {
+	const auto kinds = tokens.kinds();
+	for (Ulen i = 0; i < kinds.length(); i++) {
+		if (kinds[i] != TokenKind::LITERAL) {
+			continue;
+		}
+		const auto token = tokens[i];
+		const auto string = lexer.string(token);
+		Literal literal { Uint32(i), false, 0 };
+		switch (token.as_literal) {
+		case LiteralKind::INTEGER:
+			if (auto value = decode_integer(string)) {
+				literal = { Uint32(i), true, *value };
+			}
+			break;
+		case LiteralKind::FLOAT:
+			if (auto value = decode_float(string)) {
+				literal = { Uint32(i), true, __builtin_bit_cast(Uint64, *value) };
+			}
+			break;
+		case LiteralKind::IMAGINARY:
+			if (auto value = decode_imaginary(string)) {
+				literal = { Uint32(i), true, __builtin_bit_cast(Uint64, *value) };
+			}
+			break;
+		case LiteralKind::STRING:
+			if (decode_string(string, scratch_)) {
+				const auto ref = strings_.insert(scratch_.slice().cast<const char>());
+				if (!ref) {
+					return false;
+				}
+				literal = { Uint32(i), true, (Uint64(ref.offset) << 32) | ref.length };
+			}
+			break;
+		default:
+			break;
+		}
+		if (!literals_.push_back(literal)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+const LiteralTable::Literal* LiteralTable::find(Ulen token) const {
+	Ulen lo = 0;
+	Ulen hi = literals_.length();
+	while (lo < hi) {
+		const auto mid = lo + (hi - lo) / 2;
+		if (literals_[mid].token < token) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo < literals_.length() && literals_[lo].token == token && literals_[lo].valid) {
+		return &literals_[lo];
+	}
+	return nullptr;
+}
+
+Maybe<Uint64> LiteralTable::integer(Ulen token) const {
+	if (auto literal = find(token)) {
+		return Uint64 { literal->bits };
+	}
+	return {};
+}
+
+Maybe<Float64> LiteralTable::floating(Ulen token) const {
+	if (auto literal = find(token)) {
+		return __builtin_bit_cast(Float64, literal->bits);
+	}
+	return {};
+}
+
+Maybe<StringView> LiteralTable::string(Ulen token) const {
+	if (auto literal = find(token)) {
+		return strings_[StringRef { Uint32(literal->bits >> 32), Uint32(literal->bits) }];
+	}
+	return {};
+}
+
+} // namespace Thor
@@ -0,0 +1,55 @@
+#ifndef THOR_LITERAL_H
+#define THOR_LITERAL_H
+#include "lexer.h"
+
+namespace Thor {
+
+// The decoded values of every literal token in a TokenStream. This is a single
+// pass over the tokens after lexing so later phases never have to scan the text
+// of a literal again. Integers of every base, floating-point and imaginary
+// literals are converted without the C library, and strings have their escape
+// sequences decoded into an interned pool of their own.
+//
+// Values are looked up by the index of the literal token in the stream. A value
+// which is missing is a malformed literal, e.g an integer which does not fit in
+// 64 bits, a digit out of range for the base, or a bad escape sequence.
+struct LiteralTable {
+	LiteralTable(Allocator& allocator)
+		: literals_{allocator}
+		, strings_{allocator}
+		, scratch_{allocator}
+	{
+	}
+	LiteralTable(LiteralTable&&) = default;
+
+	// Decode every literal of [tokens] which were lexed by [lexer].
+	[[nodiscard]] Bool build(const Lexer& lexer, const TokenStream& tokens);
+
+	Maybe<Uint64> integer(Ulen token) const;
+	// The value of a FLOAT literal or the imaginary part of an IMAGINARY one.
+	Maybe<Float64> floating(Ulen token) const;
+	// The contents of a STRING literal with the quotes removed and the escape
+	// sequences replaced with what they stand for.
+	Maybe<StringView> string(Ulen token) const;
+
+	// Decode the text of a single literal.
+	static Maybe<Uint64> decode_integer(StringView string);
+	static Maybe<Float64> decode_float(StringView string);
+	static Maybe<Float64> decode_imaginary(StringView string);
+	[[nodiscard]] static Bool decode_string(StringView string, Array<char>& result);
+
+private:
+	struct Literal {
+		Uint32 token; // Index of the literal token in the stream
+		Bool   valid; // Is false for a malformed literal
+		Uint64 bits;  // The integer, the Float64 bits or the StringRef of the string
+	};
+	const Literal* find(Ulen token) const;
+	Array<Literal> literals_; // Sorted by token
+	StringTable    strings_;
+	Array<char>    scratch_;
+};
+
+} // namespace Thor
+
+#endif // THOR_LITERAL_H
@@ -1,9 +1,11 @@
+#include <string.h> // strlen
+
 #include "util/system.h"
 #include "util/file.h"
 #include "util/map.h"
 #include "util/stream.h"
 
-#include "parser.h"
+#include "package.h"
 
 #include "cg_llvm.h"
 
@@ -19,7 +21,7 @@ namespace Thor {
 
 using namespace Thor;
 
-int main(int, char **) {
+int main(int argc, char **argv) {
 	System sys {
 		STD_FILESYSTEM,
 		STD_HEAP,
@@ -30,36 +32,53 @@ int main(int, char **) {
 		STD_CHRONO,
 	};
 
-
-	auto parser = Parser::open(sys, "test/ks.odin");
-	if (!parser) {
-		return 1;
+	// thor [-j=N] [package], where N is the number of threads to parse with.
+	StringView path = "test";
+	Ulen threads = 1;
+	for (int i = 1; i < argc; i++) {
+		const StringView arg { argv[i], strlen(argv[i]) };
+		if (arg.length() > 3 && arg.truncate(3) == StringView { "-j=" }) {
+			auto value = LiteralTable::decode_integer(arg.slice(3));
+			if (!value || *value == 0) {
+				sys.console.write(sys, StringView { "Expected a number of threads for -j=\n" });
+				return 1;
+			}
+			threads = *value;
+		} else if (!arg.is_empty() && arg[0] != '-') {
+			path = arg;
+		} else {
+			sys.console.write(sys, StringView { "Usage: thor [-j=N] [package]\n" });
+			return 1;
+		}
 	}
 
-	Array<AstRef<AstStmt>> stmts{sys.allocator};
-	for (;;) {
-		auto stmt = parser->parse_stmt(false, {}, {});
-		if (!stmt) {
-			break;
-		}
-		if (!stmts.push_back(move(stmt))) {
-			break;
-		}
+	SourceManager sources{sys};
+	Diagnostics diagnostics{sys, sources};
+	auto package = Package::open(sys, sources, diagnostics, path, threads);
+	if (!diagnostics.flush() || !package) {
+		return 1;
 	}
 
-	auto& ast = parser->ast();
+	// Dump every file in the order of their paths. A file which did not parse can
+	// hold nodes which were only partly made, so it is left out.
 	StringBuilder builder{sys.allocator};
-	for (auto stmt : stmts) {
-		if (ast[stmt].is_stmt<AstEmptyStmt>()) {
+	for (auto file : package->files()) {
+		if (!file->ok) {
 			continue;
 		}
-		ast[stmt].dump(ast, builder, 0);
-		builder.put('\n');
+		const auto& ast = file->parser->ast();
+		for (auto stmt : file->stmts) {
+			if (ast[stmt].is_stmt<AstEmptyStmt>()) {
+				continue;
+			}
+			ast[stmt].dump(ast, builder, 0);
+			builder.put('\n');
+		}
 	}
 	if (auto result = builder.result()) {
 		sys.console.write(sys, *result);
 		sys.console.write(sys, StringView { "\n" });
 	}
-
-	return 0;
+	Parser::dump_stats(sys);
+	return package->is_ok() && diagnostics.errors() == 0 ? 0 : 1;
 }
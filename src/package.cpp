@@ -0,0 +1,175 @@
+#include "util/atomic.h"
+#include "util/thread.h"
+
+#include "package.h"
+
+namespace Thor {
+
+// Order of paths by their bytes.
+static Bool before(StringView lhs, StringView rhs) {
+	const auto length = lhs.length() < rhs.length() ? lhs.length() : rhs.length();
+	for (Ulen i = 0; i < length; i++) {
+		if (lhs[i] != rhs[i]) {
+			return Uint8(lhs[i]) < Uint8(rhs[i]);
+		}
+	}
+	return lhs.length() < rhs.length();
+}
+
+// Run [fn] for every one of [files] on [threads] threads, each thread takes the
+// next file which has not been taken yet until there are none.
+template<typename F>
+static void run(System& sys, Slice<Package::File*> files, Ulen threads, F&& fn) {
+	struct Worker {
+		static void run(System&, void* user) {
+			auto& worker = *static_cast<Worker*>(user);
+			for (;;) {
+				const auto index = worker.next->fetch_add(1);
+				if (index >= worker.files.length()) {
+					break;
+				}
+				(*worker.fn)(*worker.files[index]);
+			}
+		}
+		F*                          fn;
+		Slice<Package::File*>       files;
+		Atomic<Ulen>*               next;
+		Maybe<Thread>               thread;
+	};
+	if (threads > files.length()) {
+		threads = files.length();
+	}
+	Atomic<Ulen> next{0};
+	Array<Worker> workers{sys.allocator};
+	if (!workers.reserve(threads)) {
+		// Out of memory, do it all on this thread instead.
+		threads = 1;
+	}
+	for (Ulen i = 1; i < threads; i++) {
+		if (!workers.push_back({ &fn, files, &next, {} })) {
+			break;
+		}
+	}
+	// The array was reserved so starting a thread cannot move a worker.
+	for (auto& worker : workers) {
+		worker.thread = Thread::start(sys, Worker::run, &worker);
+	}
+	Worker self{ &fn, files, &next, {} };
+	Worker::run(sys, &self);
+	for (auto& worker : workers) {
+		if (worker.thread) {
+			worker.thread->join();
+		}
+	}
+}
+
+Maybe<Package> Package::open(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView path, Ulen threads) {
+	auto dir = sys.filesystem.open_dir(sys, path);
+	if (!dir) {
+		// ERROR: Could not open the directory
+		return {};
+	}
+	Package package{sys};
+	Bool ok = true;
+	Filesystem::Item item;
+	while (ok && sys.filesystem.read_dir(sys, dir, item)) {
+		using Kind = Filesystem::Item::Kind;
+		const StringView ext = ".odin";
+		if (item.kind == Kind::DIR || item.name.length() <= ext.length()) {
+			continue;
+		}
+		if (!(item.name.slice(item.name.length() - ext.length()) == ext)) {
+			continue;
+		}
+		auto file = sys.allocator.create<File>(sys);
+		if (!file || !package.files_.push_back(file)) {
+			sys.allocator.destroy(file);
+			ok = false;
+			break;
+		}
+		file->path.put(path);
+		file->path.put('/');
+		file->path.put(item.name);
+		ok = file->path.result().is_valid();
+	}
+	sys.filesystem.close_dir(sys, dir);
+	if (!ok) {
+		return {};
+	}
+
+	// Directories are read in no particular order.
+	auto& files = package.files_;
+	for (Ulen i = 1; i < files.length(); i++) {
+		auto file = files[i];
+		auto j = i;
+		for (; j > 0 && before(*file->path.result(), *files[j - 1]->path.result()); j--) {
+			files[j] = files[j - 1];
+		}
+		files[j] = file;
+	}
+
+	// Read and validate every file, which can happen in any order, then give them
+	// their locations in the order of their paths.
+	run(sys, files.slice(), threads, [](File& file) {
+		if (auto lexer = Lexer::open(file.sys, *file.path.result())) {
+			file.lexer = move(*lexer);
+		}
+	});
+	for (auto file : files) {
+		// A file which cannot be read is given a location of its own with nothing
+		// in it, to report the error at.
+		const auto input = file->lexer ? file->lexer->input() : StringView{};
+		auto base = sources.add(*file->path.result(), input);
+		if (!base) {
+			// Out of memory or source locations
+			return {};
+		}
+		file->base = *base;
+		if (!file->lexer) {
+			if (auto buffer = diagnostics.buffer()) {
+				buffer->report(*base, Severity::ERROR, "Could not read the file or it is not UTF-8");
+			}
+		}
+	}
+
+	// Threads left over when there are fewer files than threads split the files
+	// they parse into pieces instead.
+	const auto split = files.is_empty() || threads <= files.length() ? 1 : threads / files.length();
+	run(sys, files.slice(), threads, [&](File& file) {
+		if (!file.lexer) {
+			return;
+		}
+		auto adopted = Parser::adopt(file.sys, sources, diagnostics, *file.path.result(), file.base, move(*file.lexer));
+		file.lexer.reset();
+		if (!adopted) {
+			return;
+		}
+		file.parser = move(*adopted);
+		auto& parser = *file.parser;
+		if (auto stmts = parser.parse_all(split)) {
+			file.stmts = move(*stmts);
+		}
+		// Stopping anywhere but the end is a parse error, as is any error the
+		// parser carried on from.
+		file.ok = parser.is_done() && parser.errors() == 0;
+	});
+
+	return package;
+}
+
+Package::~Package() {
+	for (auto file : files_) {
+		sys_.allocator.destroy(file);
+	}
+}
+
+Bool Package::is_ok() const {
+	for (auto file : files_) {
+		if (!file->ok) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace Thor
@@ -0,0 +1,60 @@
+#ifndef THOR_PACKAGE_H
+#define THOR_PACKAGE_H
+#include "parser.h"
+
+namespace Thor {
+
+// Every .odin file in one directory, each parsed into an AstFile of its own on a
+// pool of threads. The files are ordered by name and given their source
+// locations in that order, so the result is the same however many threads did
+// the parsing.
+struct Package {
+	struct File {
+		File(const System& sys)
+			: sys{sys.clone()}
+			, path{this->sys.allocator}
+			, stmts{this->sys.allocator}
+		{
+		}
+		// The allocator of a System is not thread safe, everything parsed from the
+		// file is allocated from a System of its own.
+		System                 sys;
+		StringBuilder          path;
+		Maybe<Lexer>           lexer; // Until it is given to the parser
+		Uint32                 base = SourceManager::NONE;
+		Maybe<Parser>          parser;
+		Array<AstRef<AstStmt>> stmts; // Top-level statements in order
+		Bool                   ok = false; // Every statement parsed
+	};
+
+	// Parse every .odin file in the directory [path] with [threads] threads. The
+	// result is missing when the directory cannot be read or out of memory, a file
+	// which does not parse is reported to [diagnostics] and left with ok false.
+	static Maybe<Package> open(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView path, Ulen threads);
+
+	Package(Package&& other)
+		: sys_{other.sys_}
+		, files_{move(other.files_)}
+	{
+	}
+	~Package();
+
+	[[nodiscard]] THOR_FORCEINLINE Slice<File* const> files() const { return files_.slice(); }
+
+	// Every file parsed without error.
+	[[nodiscard]] Bool is_ok() const;
+
+private:
+	Package(System& sys)
+		: sys_{sys}
+		, files_{sys.allocator}
+	{
+	}
+
+	System&      sys_;
+	Array<File*> files_; // Ordered by path
+};
+
+} // namespace Thor
+
+#endif // THOR_PACKAGE_H
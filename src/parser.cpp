@@ -1,71 +1,479 @@
-#include <stdlib.h>
-#include <string.h> // memcpy
+#include <string.h> // strlen
 
 #include "parser.h"
 #include "ast.h"
 #include "lexer.h"
 #include "util/allocator.h"
+#include "util/thread.h"
+#include "util/atomic.h"
 
 namespace Thor {
 
-struct Debug {
-	Debug(System& sys, StringView name, StringView file, Sint32 line) {
-		ScratchAllocator<1024> scratch{sys.allocator};
-		StringBuilder builder{scratch};
-		builder.rep(s_depth*2, ' ');
-		builder.put(name);
-		builder.put(' ');
-		builder.put(file);
-		builder.put(':');
-		builder.put(line);
-		builder.put('\n');
-		if (auto result = builder.result()) {
-			sys.console.write(sys, *result);
+// Build with THOR_CFG_PARSER_STATS=1 to count the calls of every production and
+// the tokens and nodes each one consumes and makes, or 2 to also count the CPU
+// cycles spent in them. Parser::dump_stats writes the table. What a production
+// calls is counted for that production, not this one, so every column adds up
+// to the total. Otherwise TRACE compiles to nothing.
+#if THOR_CFG_PARSER_STATS
+#if defined(THOR_COMPILER_MSVC)
+#include <intrin.h> // __rdtsc
+#endif
+struct ParserStats {
+	struct Production {
+		constexpr Production(const char* name)
+			: name{name}
+		{
+		}
+		const char*   name;
+		Atomic<Uint64> calls  = 0;
+		Atomic<Uint64> tokens = 0;
+		Atomic<Uint64> nodes  = 0;
+		Atomic<Uint64> self   = 0; // Cycles in this production
+		Atomic<Uint64> total  = 0; // Cycles in this production and what it calls
+		Atomic<Bool>   linked = false;
+		Production*    next   = nullptr;
+	};
+
+	struct Scope {
+		THOR_FORCEINLINE Scope(Production& production, const Ulen& cursor, const AstFile& ast)
+			: production_{production}
+			, cursor_{cursor}
+			, ast_{ast}
+			, parent_{s_top}
+			, tokens_{cursor}
+			, nodes_{ast.nodes()}
+			, cycles_{ParserStats::cycles()}
+		{
+			s_top = this;
+		}
+		THOR_FORCEINLINE ~Scope() {
+			const auto tokens = cursor_ - tokens_;
+			const auto nodes = ast_.nodes() - nodes_;
+			const auto cycles = ParserStats::cycles() - cycles_;
+			auto& p = production_;
+			p.calls.fetch_add(1, MemoryOrder::relaxed);
+			p.tokens.fetch_add(tokens - children_.tokens, MemoryOrder::relaxed);
+			p.nodes.fetch_add(nodes - children_.nodes, MemoryOrder::relaxed);
+			p.self.fetch_add(cycles - children_.cycles, MemoryOrder::relaxed);
+			p.total.fetch_add(cycles, MemoryOrder::relaxed);
+			if (!p.linked.load(MemoryOrder::relaxed) && !p.linked.exchange(true)) {
+				link(p);
+			}
+			if (parent_) {
+				parent_->children_.tokens += tokens;
+				parent_->children_.nodes += nodes;
+				parent_->children_.cycles += cycles;
+			}
+			s_top = parent_;
+		}
+	private:
+		Production&    production_;
+		const Ulen&    cursor_;
+		const AstFile& ast_;
+		Scope*         parent_;
+		Ulen           tokens_; // Cursor on entry
+		Uint64         nodes_;  // Nodes on entry
+		Uint64         cycles_; // Cycles on entry
+		struct {
+			Uint64 tokens = 0;
+			Uint64 nodes  = 0;
+			Uint64 cycles = 0;
+		} children_;
+		static inline thread_local Scope* s_top = nullptr;
+	};
+
+	static THOR_FORCEINLINE Uint64 cycles() {
+#if THOR_CFG_PARSER_STATS >= 2
+	#if defined(__x86_64__) || defined(__i386__)
+		return __builtin_ia32_rdtsc();
+	#elif defined(__aarch64__)
+		Uint64 value;
+		asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+		return value;
+	#elif defined(THOR_COMPILER_MSVC)
+		return __rdtsc();
+	#else
+		return 0;
+	#endif
+#else
+		return 0;
+#endif
+	}
+
+	// Every production which was entered at least once.
+	static void link(Production& production) {
+		for (;;) {
+			const auto head = s_head.load();
+			production.next = head;
+			if (s_head.compare_exchange_weak(head, &production)) {
+				break;
+			}
 		}
-		s_depth++;
-	}
-	~Debug() {
-		s_depth--;
 	}
-	static inline int s_depth = 0;
+
+	static inline Atomic<Production*> s_head = nullptr;
 };
 
+#define TRACE() \
+	static constinit ParserStats::Production trace_production_{__func__}; \
+	ParserStats::Scope trace_{trace_production_, cursor_, ast_}
+#else
 #define TRACE()
-
-// #define TRACE()
-// 	auto debug_ ## __LINE__ = Debug{sys_, __func__, __FILE__, __LINE__}
-
-Uint32 Parser::eat() {
-	Uint32 offset = 0;
-	do {
-		offset = token_.offset;
-		token_ = lexer_.next();
-	} while (is_kind(TokenKind::COMMENT));
-	return offset;
+#endif
+
+#if THOR_CFG_PARSER_STATS
+void Parser::dump_stats(System& sys) {
+	using Production = ParserStats::Production;
+	Array<Production*> productions{sys.allocator};
+	Production sum{"total"};
+	for (auto p = ParserStats::s_head.load(); p; p = p->next) {
+		if (!productions.push_back(p)) {
+			// Out of memory
+			return;
+		}
+		sum.calls.fetch_add(p->calls.load());
+		sum.tokens.fetch_add(p->tokens.load());
+		sum.nodes.fetch_add(p->nodes.load());
+		sum.self.fetch_add(p->self.load());
+	}
+	sum.total.store(sum.self.load());
+
+	// Most cycles first, or most tokens when not counting cycles.
+	auto key = [](const Production* p) {
+		return THOR_CFG_PARSER_STATS >= 2 ? p->self.load() : p->tokens.load();
+	};
+	for (Ulen i = 1; i < productions.length(); i++) {
+		auto p = productions[i];
+		auto j = i;
+		for (; j > 0 && key(productions[j - 1]) < key(p); j--) {
+			productions[j] = productions[j - 1];
+		}
+		productions[j] = p;
+	}
+
+	StringBuilder builder{sys.allocator};
+	auto column = [&](Ulen width, Uint64 value) {
+		ScratchAllocator<64> scratch{sys.allocator};
+		StringBuilder number{scratch};
+		number.put(value);
+		const auto view = number.result();
+		const auto length = view ? view->length() : 0;
+		builder.rep(width > length ? width - length : 1);
+		if (view) {
+			builder.put(*view);
+		}
+	};
+	auto row = [&](const Production& p) {
+		builder.rpad(28, StringView { p.name, strlen(p.name) });
+		column(12, p.calls.load());
+		column(12, p.tokens.load());
+		column(12, p.nodes.load());
+		if (THOR_CFG_PARSER_STATS >= 2) {
+			column(16, p.self.load());
+			column(16, p.total.load());
+		}
+		builder.put('\n');
+	};
+	builder.rpad(28, StringView { "production" });
+	builder.put("       calls      tokens       nodes");
+	if (THOR_CFG_PARSER_STATS >= 2) {
+		builder.put("     self cycles    total cycles");
+	}
+	builder.put('\n');
+	for (auto p : productions) {
+		row(*p);
+	}
+	row(sum);
+	if (auto result = builder.result()) {
+		sys.console.write(sys, *result);
+	}
 }
+#endif
 
-Maybe<Parser> Parser::open(System& sys, StringView filename) {
+Maybe<Parser> Parser::open(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView filename) {
 	auto lexer = Lexer::open(sys, filename);
 	if (!lexer) {
 		// Could not open filename
 		return {};
 	}
-	auto file = AstFile::create(sys, filename);
+	return adopt(sys, sources, diagnostics, filename, move(*lexer));
+}
+
+Maybe<Parser> Parser::create(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView filename, Array<Uint8>&& source) {
+	auto lexer = Lexer::create(move(source));
+	if (!lexer) {
+		// Out of memory or not UTF-8
+		return {};
+	}
+	return adopt(sys, sources, diagnostics, filename, move(*lexer));
+}
+
+Maybe<Parser> Parser::adopt(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView filename, Lexer&& lexer) {
+	auto base = sources.add(filename, lexer.input());
+	if (!base) {
+		// Out of memory or source locations
+		return {};
+	}
+	return adopt(sys, sources, diagnostics, filename, *base, move(lexer));
+}
+
+Maybe<Parser> Parser::adopt(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView filename, Uint32 base, Lexer&& lexer) {
+	auto tokens = lexer.tokenize_all(sys.allocator);
+	if (!tokens) {
+		// Out of memory
+		return {};
+	}
+	LiteralTable literals{sys.allocator};
+	if (!literals.build(lexer, *tokens)) {
+		// Out of memory
+		return {};
+	}
+	// Each node takes at least one token, so there are never more of any kind.
+	auto file = AstFile::create(sys, filename, tokens->length());
 	if (!file) {
 		// Could not create astfile
 		return {};
 	}
-	return Parser { sys, move(*lexer), move(*file) };
+	auto input = sys.allocator.create<Input>(move(lexer), move(*tokens), move(literals));
+	if (!input) {
+		// Out of memory
+		return {};
+	}
+	return Parser { sys, sources, diagnostics, base, input, true, move(*file) };
 }
 
-Parser::Parser(System& sys, Lexer&& lexer, AstFile&& ast)
+Parser::Parser(System& sys, SourceManager& sources, Diagnostics& diagnostics, Uint32 base, Input* input, Bool owner, AstFile&& ast)
 	: sys_{sys}
+	, sources_{sources}
+	, diagnostics_{diagnostics}
+	, base_{base}
 	, temporary_{static_cast<Allocator&>(sys.allocator)}
 	, ast_{move(ast)}
-	, lexer_{move(lexer)}
-	, token_{TokenKind::INVALID, 0, 0}
+	, input_{input}
+	, owner_{owner}
+	, lexer_{input->lexer}
+	, tokens_{input->tokens}
+	, literals_{input->literals}
+	, token_{tokens_[0]}
+	, deferred_{sys.allocator}
+{
+}
+
+Parser::Parser(Parser&& other)
+	: sys_{other.sys_}
+	, sources_{other.sources_}
+	, diagnostics_{other.diagnostics_}
+	, buffer_{exchange(other.buffer_, nullptr)}
+	, base_{other.base_}
+	, temporary_{move(other.temporary_)}
+	, ast_{move(other.ast_)}
+	, input_{exchange(other.input_, nullptr)}
+	, owner_{exchange(other.owner_, false)}
+	, lexer_{other.lexer_}
+	, tokens_{other.tokens_}
+	, literals_{other.literals_}
+	, cursor_{other.cursor_}
+	, token_{other.token_}
+	, expr_level_{other.expr_level_}
+	, allow_in_expr_{other.allow_in_expr_}
+	, defer_bodies_{other.defer_bodies_}
+	, quiet_{other.quiet_}
+	, errors_{other.errors_}
+	, deferred_{move(other.deferred_)}
 {
-	eat();
+}
+
+Parser::~Parser() {
+	if (owner_) {
+		sys_.allocator.destroy(input_);
+	}
+}
+
+Maybe<Array<Ulen>> Parser::split(Ulen pieces) const {
+	// A piece begins with a declaration at the top level, which is a name and a
+	// ':' after a semicolon with no brace, paren or bracket open. This only has to
+	// look at the kinds of tokens and the sub-kinds of operators.
+	const auto kinds = tokens_.kinds();
+	const auto subs = tokens_.subs();
+	const auto end = kinds.length() - 1; // The ENDOF
+	const auto step = (end - cursor_) / pieces;
+	Array<Ulen> bounds{sys_.allocator};
+	if (!bounds.push_back(cursor_)) {
+		return {};
+	}
+	Sint64 depth = 0;
+	for (auto i = cursor_; i + 2 < end && bounds.length() < pieces; i++) {
+		switch (kinds[i]) {
+		case TokenKind::LBRACE:
+			depth++;
+			break;
+		case TokenKind::RBRACE:
+			depth--;
+			break;
+		case TokenKind::OPERATOR:
+			switch (OperatorKind(subs[i])) {
+			case OperatorKind::LPAREN: case OperatorKind::LBRACKET:
+				depth++;
+				break;
+			case OperatorKind::RPAREN: case OperatorKind::RBRACKET:
+				depth--;
+				break;
+			default:
+				break;
+			}
+			break;
+		case TokenKind::EXPLICITSEMI: case TokenKind::IMPLICITSEMI:
+			if (depth == 0
+			 && i + 1 >= bounds.last() + step
+			 && kinds[i + 1] == TokenKind::IDENTIFIER
+			 && kinds[i + 2] == TokenKind::OPERATOR
+			 && OperatorKind(subs[i + 2]) == OperatorKind::COLON
+			 && !bounds.push_back(i + 1))
+			{
+				return {};
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	if (!bounds.push_back(end)) {
+		return {};
+	}
+	return bounds;
+}
+
+Bool Parser::parse_until(Ulen end, Array<AstRef<AstStmt>>& stmts) {
+	while (cursor_ < end) {
+		auto stmt = parse_stmt(false, {}, {});
+		if (!stmt || !stmts.push_back(stmt)) {
+			if (ast_.is_unreserved()) {
+				unreserved();
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+void Parser::unreserved() {
+	error("Could not reserve address space for {} nodes of each kind", Uint64(ast_.capacity()));
+}
+
+Maybe<Array<AstRef<AstStmt>>> Parser::parse_all(Ulen threads) {
+	// Not worth splitting a file into pieces smaller than this.
+	static constexpr const Ulen MIN_TOKENS = 64 * 1024;
+	if (threads > (tokens_.length() - cursor_) / MIN_TOKENS) {
+		threads = (tokens_.length() - cursor_) / MIN_TOKENS;
+	}
+
+	// Deferred bodies are kept by the parser which skipped them, so pieces would
+	// lose them. Those are parsed on one thread.
+	Maybe<Array<Ulen>> bounds;
+	if (threads > 1 && !defer_bodies_) {
+		bounds = split(threads);
+		if (!bounds) {
+			return {};
+		}
+	}
+	const auto n_pieces = bounds ? bounds->length() - 1 : 1;
+
+	// Every piece after the first is parsed on a thread of its own, with a System
+	// of its own as the allocator of a System is not thread safe. Errors are not
+	// reported from them, a piece which does not parse is parsed again below.
+	struct Piece {
+		Piece(const System& sys)
+			: sys{sys.clone()}
+			, stmts{this->sys.allocator}
+		{
+		}
+		static void run(System&, void* user) {
+			auto& piece = *static_cast<Piece*>(user);
+			piece.ok = piece.parser->parse_until(piece.end, piece.stmts)
+			        && piece.parser->cursor_ == piece.end
+			        && piece.parser->errors_ == 0;
+		}
+		System                 sys;
+		Maybe<Parser>          parser;
+		Array<AstRef<AstStmt>> stmts;
+		Ulen                   end = 0;
+		Bool                   ok = false;
+		Maybe<Thread>          thread;
+	};
+	Array<Piece*> pieces{sys_.allocator};
+	auto destroy = [&] {
+		for (auto piece : pieces) {
+			sys_.allocator.destroy(piece);
+		}
+	};
+	for (Ulen i = 1; i < n_pieces; i++) {
+		auto piece = sys_.allocator.create<Piece>(sys_);
+		if (!piece || !pieces.push_back(piece)) {
+			sys_.allocator.destroy(piece);
+			destroy();
+			return {};
+		}
+		auto ast = AstFile::create(piece->sys, ast_.filename(), (*bounds)[i + 1] - (*bounds)[i]);
+		if (!ast) {
+			destroy();
+			return {};
+		}
+		piece->parser = Parser{piece->sys, sources_, diagnostics_, base_, input_, false, move(*ast)};
+		piece->parser->quiet_ = true;
+		piece->parser->cursor_ = (*bounds)[i];
+		piece->parser->token_ = tokens_[(*bounds)[i]];
+		piece->end = (*bounds)[i + 1];
+	}
+	for (auto piece : pieces) {
+		piece->thread = Thread::start(sys_, Piece::run, piece);
+		if (!piece->thread) {
+			Piece::run(sys_, piece);
+		}
+	}
+
+	// The first piece is parsed on this thread, a parse error in it is reported
+	// and ends parsing just like it would on one thread.
+	Array<AstRef<AstStmt>> stmts{sys_.allocator};
+	const auto ok = parse_until(bounds ? (*bounds)[1] : tokens_.length(), stmts);
+	for (auto piece : pieces) {
+		if (piece->thread) {
+			piece->thread->join();
+		}
+	}
+	if (!ok) {
+		destroy();
+		return stmts;
+	}
+
+	// Merge the pieces in order for as long as each one carries on from exactly
+	// where the one before it ended. Parsing from the first which does not
+	// continues on this thread, which reports the error that stopped it.
+	for (Ulen i = 0; i < pieces.length(); i++) {
+		auto piece = pieces[i];
+		if (cursor_ != (*bounds)[i + 1] || !piece->ok) {
+			break;
+		}
+		auto remap = ast_.merge(piece->parser->ast());
+		if (!remap || !stmts.reserve(stmts.length() + piece->stmts.length())) {
+			if (ast_.is_unreserved()) {
+				unreserved();
+			}
+			destroy();
+			return {};
+		}
+		for (auto stmt : piece->stmts) {
+			(*remap)(stmt);
+			if (!stmts.push_back(stmt)) {
+				destroy();
+				return {};
+			}
+		}
+		cursor_ = piece->end;
+		token_ = tokens_[cursor_];
+	}
+	destroy();
+	parse_until(tokens_.length(), stmts);
+	return stmts;
 }
 
 AstStringRef Parser::parse_ident(Uint32* poffset) {
@@ -81,15 +489,69 @@ AstStringRef Parser::parse_ident(Uint32* poffset) {
 
 AstRef<AstProcExpr> Parser::parse_proc_expr() {
 	TRACE();
+	// The type may be shared with other spellings, the location is of this 'proc'.
+	const auto offset = base_ + token_.offset;
 	AstRef<AstProcType> type = parse_proc_type();
 	if (!type) {
 		return {};
 	}
+	if (defer_bodies_ && is_kind(TokenKind::LBRACE)) {
+		// Find the matching '}' from the token kinds alone. A body without one will
+		// not parse, that is left to the eager path to report.
+		const auto kinds = tokens_.kinds();
+		Ulen depth = 0;
+		for (auto end = cursor_; end < kinds.length() && kinds[end] != TokenKind::ENDOF; end++) {
+			if (kinds[end] == TokenKind::LBRACE) {
+				depth++;
+			} else if (kinds[end] == TokenKind::RBRACE && --depth == 0) {
+				auto proc = ast_.create<AstProcExpr>(offset, type, AstRef<AstBlockStmt>{});
+				if (!proc || !deferred_.push_back({ proc, cursor_, allow_in_expr_ })) {
+					return {};
+				}
+				cursor_ = end;
+				token_ = tokens_[cursor_];
+				eat(); // Eat '}'
+				return proc;
+			}
+		}
+	}
 	auto block = parse_block_stmt();
 	if (!block) {
 		return {};
 	}
-	return ast_.create<AstProcExpr>(ast_[type].offset, type, block);
+	return ast_.create<AstProcExpr>(offset, type, block);
+}
+
+Bool Parser::force_body(Ulen index) {
+	// Forcing can defer more bodies which may move deferred_, take a copy.
+	const auto deferred = deferred_[index];
+	if (ast_[deferred.proc].body) {
+		return true;
+	}
+	const auto cursor = cursor_;
+	const auto token = token_;
+	const auto allow_in_expr = allow_in_expr_;
+	cursor_ = deferred.cursor;
+	token_ = tokens_[cursor_];
+	allow_in_expr_ = deferred.allow_in_expr;
+	auto block = parse_block_stmt();
+	cursor_ = cursor;
+	token_ = token;
+	allow_in_expr_ = allow_in_expr;
+	if (!block) {
+		return false;
+	}
+	ast_[deferred.proc].body = block;
+	return true;
+}
+
+Bool Parser::force_bodies() {
+	for (Ulen i = 0; i < deferred_.length(); i++) {
+		if (!force_body(i)) {
+			return false;
+		}
+	}
+	return true;
 }
 
 AstRef<AstExpr> Parser::parse_paren_expr() {
@@ -137,7 +599,10 @@ AstRef<AstStmt> Parser::parse_stmt(Bool is_using,
 		// 	'@' 'attribute'
 		// 	'@' '(' 'attribute' ('=' Expr)? (',' 'attribute' ('=' Expr)?)* ')'
 		// In the statement scope. The attribute applies to the statement that will
-		// proceed it. Just pass it along recursively.
+		// proceed it. Just pass it along recursively. The list lives in temporary_
+		// until the statement copies it into ast_, so the mark is taken here and
+		// not in parse_attributes.
+		TemporaryAllocator::Scope scope{temporary_};
 		if (auto attributes = parse_attributes()) {
 			return parse_stmt(false, {}, move(attributes));
 		} else {
@@ -148,7 +613,9 @@ AstRef<AstStmt> Parser::parse_stmt(Bool is_using,
 		//	'#' Ident
 		//	'#' Ident '(' Expr (',' Expr)* ')'
 		// In the statement scope. The directive applies to the statement that will
-		// proceed it. Just pass it along recursively.
+		// proceed it. Just pass it along recursively. As with attributes the mark
+		// is taken here so the list outlives the statement that consumes it.
+		TemporaryAllocator::Scope scope{temporary_};
 		if (auto directives = parse_directives()) {
 			return parse_stmt(false, move(directives), {});
 		} else {
@@ -210,6 +677,7 @@ AstRef<AstStmt> Parser::parse_stmt(Bool is_using,
 			return ast_.create<AstExprStmt>(ast_[expr].offset, expr);
 		}
 
+		TemporaryAllocator::Scope scope{temporary_};
 		Array<AstRef<AstExpr>> lhs{temporary_};
 		Array<AstRef<AstExpr>> rhs{temporary_};
 		AstRef<AstType> type; // Optional type
@@ -334,6 +802,7 @@ AstRef<AstBlockStmt> Parser::parse_block_stmt() {
 		return {};
 	}
 	auto offset = eat(); // Eat '{'
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstStmt>> stmts{temporary_};
 	while (!is_kind(TokenKind::RBRACE) && !is_kind(TokenKind::ENDOF)) {
 		auto stmt = parse_stmt(false, {}, {});
@@ -451,6 +920,7 @@ AstRef<AstForeignImportStmt> Parser::parse_foreign_import_stmt() {
 			return {};
 		}
 	}
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstExpr>> exprs{temporary_};
 	if (is_kind(TokenKind::LBRACE)) {
 		eat(); // Eat '{'
@@ -546,10 +1016,12 @@ AstRef<AstIfStmt> Parser::parse_if_stmt() {
 
 // DoStmt := 'do' Stmt
 AstRef<AstBlockStmt> Parser::parse_do_stmt() {
+	TRACE();
 	if (!is_keyword(KeywordKind::DO)) {
 		return error("Expected 'do'");
 	}
 	auto offset = eat(); // Eat 'do'
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstStmt>> stmts{temporary_};
 	auto stmt = parse_stmt(false, {}, {});
 	if (!stmt || !stmts.push_back(stmt)) {
@@ -613,12 +1085,17 @@ AstRef<AstForStmt> Parser::parse_for_stmt() {
 	AstRef<AstStmt> in;
 	AstRef<AstStmt> post;
 	AstRef<AstExpr> cond;
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstStmt>> stmts{temporary_};
 
 
 	if (is_operator(OperatorKind::LPAREN)) {
+		// Only the parenthesized clause may use 'in', do not let it leak into the
+		// rest of the file.
+		const auto allow_in_expr = allow_in_expr_;
 		allow_in_expr_ = true;
 		cond = parse_expr(false);
+		allow_in_expr_ = allow_in_expr;
 	} else {
 
 		auto first_stmt = parse_stmt(false, {}, {});
@@ -691,6 +1168,7 @@ AstRef<AstReturnStmt> Parser::parse_return_stmt() {
 		return error("Expected 'return'");
 	}
 	auto offset = eat(); // Eat 'return'
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstExpr>> exprs{temporary_};
 	for (;;) {
 		auto expr = parse_expr(false);
@@ -752,17 +1230,12 @@ AstRef<AstIntExpr> Parser::parse_int_expr() {
 	if (!is_literal(LiteralKind::INTEGER)) {
 		return error("Expected integer literal");
 	}
-	auto string = lexer_.string(token_);
-	char buf[1024];
-	memcpy(buf, string.data(), string.length());
-	buf[string.length()] = '\0';
-	char* end = nullptr;
-	auto value = strtoul(buf, &end, 10);
-	if (*end != '\0') {
+	auto value = literals_.integer(cursor_);
+	if (!value) {
 		return error("Malformed integer literal");
 	}
 	auto offset = eat(); // Eat literal
-	return ast_.create<AstIntExpr>(offset, value);
+	return ast_.create<AstIntExpr>(offset, *value);
 }
 
 // FloatExpr := FloatLit
@@ -771,17 +1244,12 @@ AstRef<AstFloatExpr> Parser::parse_float_expr() {
 	if (!is_literal(LiteralKind::FLOAT)) {
 		return error("Expected floating-point literal");
 	}
-	auto string = lexer_.string(token_);
-	char buf[1024];
-	memcpy(buf, string.data(), string.length());
-	buf[string.length()] = '\0';
-	char* end = nullptr;
-	auto value = strtod(buf, &end);
-	if (*end != '\0') {
+	auto value = literals_.floating(cursor_);
+	if (!value) {
 		return error("Malformed floating-point literal");
 	}
 	auto offset = eat(); // Eat literal
-	return ast_.create<AstFloatExpr>(offset, value);
+	return ast_.create<AstFloatExpr>(offset, *value);
 }
 
 // StringExpr := StringLit
@@ -790,10 +1258,11 @@ AstRef<AstStringExpr> Parser::parse_string_expr() {
 	if (!is_literal(LiteralKind::STRING)) {
 		return error("Expected string literal");
 	}
-	auto strip = lexer_.string(token_);
-	strip = strip.slice(1);                     // Remove '"' (or '`')
-	strip = strip.truncate(strip.length() - 1); // Remove '"' (or '`')
-	auto ref = ast_.insert(strip);
+	auto value = literals_.string(cursor_);
+	if (!value) {
+		return error("Malformed string literal");
+	}
+	auto ref = ast_.insert(*value);
 	if (!ref) {
 		return {};
 	}
@@ -807,18 +1276,12 @@ AstRef<AstImaginaryExpr> Parser::parse_imaginary_expr() {
 	if (!is_literal(LiteralKind::IMAGINARY)) {
 		return error("Expected imaginary literal");
 	}
-	auto strip = lexer_.string(token_);
-	strip = strip.truncate(strip.length() - 1); // Remove trailing 'i', 'j', or 'k'
-	char buf[1024];
-	memcpy(buf, strip.data(), strip.length());
-	buf[strip.length()] = '\0';
-	char* end = nullptr;
-	auto value = strtod(buf, &end);
-	if (*end != '\0') {
+	auto value = literals_.floating(cursor_);
+	if (!value) {
 		return error("Malformed imaginary literal");
 	}
 	auto offset = eat(); // Eat literal
-	return ast_.create<AstImaginaryExpr>(offset, value);
+	return ast_.create<AstImaginaryExpr>(offset, *value);
 }
 
 // CompoundExpr := '{' Field (',' Field)* '}'
@@ -828,6 +1291,7 @@ AstRef<AstCompoundExpr> Parser::parse_compound_expr() {
 	if (is_kind(TokenKind::IMPLICITSEMI)) {
 		eat(); // Eat ';'
 	}
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstField>> fields{temporary_};
 	while (!is_kind(TokenKind::RBRACE) && !is_kind(TokenKind::ENDOF)) {
 		auto field = parse_field(true);
@@ -1008,6 +1472,7 @@ AstRef<AstExpr> Parser::parse_bin_expr(Bool lhs, Uint32 prec) {
 
 // DerefExpr := Expr '^'
 AstRef<AstDerefExpr> Parser::parse_deref_expr(AstRef<AstExpr> operand) {
+	TRACE();
 	if (!is_operator(OperatorKind::POINTER)) {
 		return error("Expected '^'");
 	}
@@ -1017,6 +1482,7 @@ AstRef<AstDerefExpr> Parser::parse_deref_expr(AstRef<AstExpr> operand) {
 
 // OrReturnExpr := Expr 'or_return'
 AstRef<AstOrReturnExpr> Parser::parse_or_return_expr(AstRef<AstExpr> operand) {
+	TRACE();
 	if (!is_operator(OperatorKind::OR_RETURN)) {
 		return error("Expected 'or_return'");
 	}
@@ -1026,6 +1492,7 @@ AstRef<AstOrReturnExpr> Parser::parse_or_return_expr(AstRef<AstExpr> operand) {
 
 // OrBreakExpr := Expr 'or_break'
 AstRef<AstOrBreakExpr> Parser::parse_or_break_expr(AstRef<AstExpr> operand) {
+	TRACE();
 	if (!is_operator(OperatorKind::OR_BREAK)) {
 		return error("Expected 'or_break'");
 	}
@@ -1035,6 +1502,7 @@ AstRef<AstOrBreakExpr> Parser::parse_or_break_expr(AstRef<AstExpr> operand) {
 
 // OrContinueExpr := Expr 'or_continue'
 AstRef<AstOrContinueExpr> Parser::parse_or_continue_expr(AstRef<AstExpr> operand) {
+	TRACE();
 	if (!is_operator(OperatorKind::OR_CONTINUE)) {
 		return error("Expected 'or_continue'");
 	}
@@ -1049,6 +1517,7 @@ AstRef<AstCallExpr> Parser::parse_call_expr(AstRef<AstExpr> operand) {
 		return error("Expected '('");
 	}
 	eat(); // Eat '('
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstField>> args{temporary_};
 	while (!is_operator(OperatorKind::RPAREN) && !is_kind(TokenKind::ENDOF)) {
 		auto field = parse_field(true);
@@ -1229,18 +1698,21 @@ AstRef<AstExpr> Parser::parse_operand(Bool is_lhs) {
 			return parse_compound_expr();
 		}
 	}
+	// Types can be shared, see AstTypeKey, so the location is that of this
+	// spelling rather than that of the type.
+	const auto offset = base_ + token_.offset;
 	auto type = parse_type();
 	if (!type) {
 		return {};
 	}
 	if (is_kind(TokenKind::LBRACE)) {
 		if (auto struct_literal = parse_compound_expr()) {
-			return ast_.create<AstCastExpr>(ast_[type].offset, type, struct_literal);
+			return ast_.create<AstCastExpr>(offset, type, struct_literal);
 		} else {
 			return {};
 		}
 	} else {
-		return ast_.create<AstTypeExpr>(ast_[type].offset, type);
+		return ast_.create<AstTypeExpr>(offset, type);
 	}
 }
 
@@ -1293,12 +1765,14 @@ AstRef<AstType> Parser::parse_type() {
 	} else if (is_keyword(KeywordKind::BITSET)) {
 		return parse_bitset_type();
 	} else if (is_kind(TokenKind::IDENTIFIER)) {
+		const auto offset = base_ + token_.offset;
 		auto named = parse_named_type();
 		if (!named) {
 			return {};
 		}
 		if (is_operator(OperatorKind::LPAREN)) {
 			eat(); // Eat '('
+			TemporaryAllocator::Scope scope{temporary_};
 			Array<AstRef<AstExpr>> exprs{temporary_};
 			while (!is_operator(OperatorKind::RPAREN) && !is_kind(TokenKind::ENDOF)) {
 				auto expr = parse_expr(false);
@@ -1316,7 +1790,7 @@ AstRef<AstType> Parser::parse_type() {
 			}
 			eat(); // Eat ')'
 			auto refs = ast_.insert(move(exprs));
-			return ast_.create<AstParamType>(ast_[named].offset, named, refs);
+			return ast_.create<AstParamType>(offset, named, refs);
 		} else {
 			return named;
 		}
@@ -1348,6 +1822,7 @@ AstRef<AstUnionType> Parser::parse_union_type() {
 	if (!is_kind(TokenKind::LBRACE)) {
 		return error("Expected '{'");
 	}
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstType>> types{temporary_};
 	eat(); // Eat '}'
 	while (!is_kind(TokenKind::RBRACE) && !is_kind(TokenKind::ENDOF)) {
@@ -1385,6 +1860,7 @@ AstRef<AstStructType> Parser::parse_struct_type() {
 	if (!is_kind(TokenKind::LBRACE)) {
 		return error("Expected '{'");
 	}
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstStmt>> decls{temporary_};
 	eat(); // Eat '}'
 	while (!is_kind(TokenKind::RBRACE) && !is_kind(TokenKind::ENDOF)) {
@@ -1435,6 +1911,7 @@ AstRef<AstEnumType> Parser::parse_enum_type() {
 		return error("Expected '{'");
 	}
 	eat(); // Eat '{'
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstField>> enums{temporary_};
 	while (!is_kind(TokenKind::RBRACE) && !is_kind(TokenKind::ENDOF)) {
 		auto field = parse_field(true);
@@ -1499,6 +1976,7 @@ AstRef<AstProcType> Parser::parse_proc_type() {
 	}
 	eat(); // Eat '('
 
+	TemporaryAllocator::Scope scope{temporary_};
 	Array<AstRef<AstStmt>> decls{temporary_};
 	while (!is_operator(OperatorKind::RPAREN) && !is_kind(TokenKind::ENDOF)) {
 		auto decl = parse_stmt(false, {}, {});
@@ -1568,11 +2046,12 @@ AstRef<AstProcType> Parser::parse_proc_type() {
 			}
 			eat(); // Eat ')'
 		} else {
+			const auto location = base_ + token_.offset;
 			auto type = parse_type();
 			if (!type) {
 				return {};
 			}
-			auto expr = ast_.create<AstTypeExpr>(ast_[type].offset, type);
+			auto expr = ast_.create<AstTypeExpr>(location, type);
 			auto decl = ast_.create<AstExprStmt>(ast_[expr].offset, expr);
 			if (!types.push_back(decl)) {
 				return {};
@@ -1734,6 +2213,7 @@ AstRef<AstMatrixType> Parser::parse_matrix_type() {
 
 // BitsetType := 'bit_set' '[' Expr (';' Type)? ']'
 AstRef<AstBitsetType> Parser::parse_bitset_type() {
+	TRACE();
 	// *(volatile int *)0 = 0;
 	if (!is_keyword(KeywordKind::BITSET)) {
 		return error("Expected 'bitset'");
@@ -1880,6 +2360,7 @@ AstRef<AstDirective> Parser::parse_directive() {
 	AstRefArray<AstExpr> refs;
 	if (is_operator(OperatorKind::LPAREN)) {
 		eat(); // Eat '('
+		TemporaryAllocator::Scope scope{temporary_};
 		Array<AstRef<AstExpr>> exprs{temporary_};
 		while (!is_operator(OperatorKind::RPAREN) && !is_kind(TokenKind::ENDOF)) {
 			auto expr = parse_expr(false);
@@ -1,13 +1,33 @@
 #ifndef THOR_PARSER_H
 #define THOR_PARSER_H
-#include "lexer.h"
+#include "literal.h"
+#include "source.h"
+#include "diagnostic.h"
 #include "ast.h"
 #include "util/system.h"
 
 namespace Thor {
 
 struct Parser {
-	static Maybe<Parser> open(System& sys, StringView file);
+	// The file is added to [sources] and the AST holds locations from there.
+	// Errors are reported to [diagnostics] and written when that is flushed.
+	static Maybe<Parser> open(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView file);
+	// Parse [source] which is already in memory as though it were read from [file].
+	static Maybe<Parser> create(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView file, Array<Uint8>&& source);
+	// Parse the input of [lexer] which was already added to [sources] at [base],
+	// for when files must be given their locations in a fixed order.
+	static Maybe<Parser> adopt(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView file, Uint32 base, Lexer&& lexer);
+
+	Parser(Parser&& other);
+	~Parser();
+
+	// Write the table of calls, tokens, nodes and cycles counted for every
+	// production by a build with THOR_CFG_PARSER_STATS, otherwise nothing.
+#if THOR_CFG_PARSER_STATS
+	static void dump_stats(System& sys);
+#else
+	static void dump_stats(System&) {}
+#endif
 	AstStringRef parse_ident(Uint32* poffset = nullptr);
 
 	using DirectiveList = Maybe<Array<AstRef<AstDirective>>>;
@@ -82,6 +102,39 @@ struct Parser {
 	AttributeList parse_attributes();
 	DirectiveList parse_directives();
 
+	// Procedure bodies are skipped over by matching braces instead of being
+	// parsed, the AstProcExpr is given an invalid body until it is forced. This
+	// makes a first pass over a file which only needs its declarations cheap.
+	THOR_FORCEINLINE void defer_bodies() { defer_bodies_ = true; }
+
+	// The number of bodies deferred so far, forcing a body can add more when it
+	// holds procedure literals of its own.
+	[[nodiscard]] THOR_FORCEINLINE Ulen deferred() const { return deferred_.length(); }
+
+	// Parse the deferred body [index] and give it to its AstProcExpr. Bodies may
+	// be forced in any order, on whichever thread owns the parser. Once every
+	// body is forced the AST is the same as the one parsed without deferring.
+	// False when the body does not parse, which is only reported now.
+	[[nodiscard]] Bool force_body(Ulen index);
+
+	// Force every deferred body, including those found while forcing.
+	[[nodiscard]] Bool force_bodies();
+
+	// Parse the statements up to the end of the file, as calling parse_stmt until
+	// it fails would. With more than one of [threads] a large file is split at
+	// top-level declarations and the pieces are parsed on threads of their own,
+	// each into an AST of its own which is then merged into this one in order.
+	// The result is the same as parsing on one thread. Use is_done() to tell if
+	// it stopped at a parse error. Missing when out of memory.
+	Maybe<Array<AstRef<AstStmt>>> parse_all(Ulen threads = 1);
+
+	// Every statement has been parsed.
+	[[nodiscard]] THOR_FORCEINLINE constexpr Bool is_done() const { return is_kind(TokenKind::ENDOF); }
+
+	// The number of errors found in the file so far. The parser can reach the end
+	// of a file which has errors, so the file only parsed when this is zero too.
+	[[nodiscard]] THOR_FORCEINLINE constexpr Ulen errors() const { return errors_; }
+
 	[[nodiscard]] THOR_FORCEINLINE constexpr AstFile& ast() { return ast_; }
 	[[nodiscard]] THOR_FORCEINLINE constexpr const AstFile& ast() const { return ast_; }
 private:
@@ -90,35 +143,47 @@ private:
 
 	AstRef<AstDirective> parse_directive();
 
-	Parser(System& sys, Lexer&& lexer, AstFile&& ast);
+	// Everything read from the file. Parsers of the pieces of a file split by
+	// parse_all only read this so they share the one of the parser of the file.
+	struct Input {
+		Lexer        lexer;
+		TokenStream  tokens;
+		LiteralTable literals;
+	};
+
+	static Maybe<Parser> adopt(System& sys, SourceManager& sources, Diagnostics& diagnostics, StringView file, Lexer&& lexer);
+	Parser(System& sys, SourceManager& sources, Diagnostics& diagnostics, Uint32 base, Input* input, Bool owner, AstFile&& ast);
+
+	// Token indices to split the statements from the cursor on into [pieces] at.
+	Maybe<Array<Ulen>> split(Ulen pieces) const;
+
+	// Parse statements into [stmts] until the cursor reaches [end], false when one
+	// does not parse or out of memory.
+	Bool parse_until(Ulen end, Array<AstRef<AstStmt>>& stmts);
+
+	// Report that the AST ran out of address space, which is not a parse error
+	// but is not silent like running out of memory.
+	void unreserved();
 
 	template<Ulen E, typename... Ts>
-	Unit error(Uint32 offset, const char (&msg)[E], Ts&&...) {
-		ScratchAllocator<1024> scratch{sys_.allocator};
-		StringBuilder builder{scratch};
-		auto position = lexer_.position(offset);
-		builder.put(ast_.filename());
-		builder.put(':');
-		builder.put(position.line);
-		builder.put(':');
-		builder.put(position.column);
-		builder.put(':');
-		builder.put(' ');
-		builder.put("error");
-		builder.put(':');
-		builder.put(' ');
-		builder.put(StringView { msg });
-		builder.put('\n');
-		if (auto result = builder.result()) {
-			sys_.console.write(sys_, *result);
-		} else {
-			sys_.console.write(sys_, StringView { "Out of memory" });
+	Unit error(Uint32 location, const char (&msg)[E], Ts&&... args) {
+		errors_++;
+		if (quiet_) {
+			return {};
 		}
+		if (!buffer_) {
+			buffer_ = diagnostics_.buffer();
+			if (!buffer_) {
+				// Out of memory
+				return {};
+			}
+		}
+		buffer_->report(location, Severity::ERROR, msg, forward<Ts>(args)...);
 		return {};
 	}
 	template<Ulen E, typename... Ts>
 	Unit error(const char (&msg)[E], Ts&&... args) {
-		return error(token_.offset, msg, forward<Ts>(args)...);
+		return error(base_ + token_.offset, msg, forward<Ts>(args)...);
 	}
 	THOR_FORCEINLINE constexpr Bool is_kind(TokenKind kind) const {
 		return token_.kind == kind;
@@ -139,19 +204,54 @@ private:
 		return is_kind(TokenKind::ASSIGNMENT) && token_.as_assign == kind;
 	}
 
-	// Eat the current token, advancing the lexer and return the byte position of
-	// the previous token.
-	Uint32 eat();
+	// Eat the current token, advancing the cursor and return the source location
+	// of the previous token.
+	THOR_FORCEINLINE Uint32 eat() {
+		const auto location = base_ + token_.offset;
+		// The stream always ends with ENDOF, the cursor stays on it once reached.
+		if (cursor_ + 1 < tokens_.length()) {
+			cursor_++;
+		}
+		token_ = tokens_[cursor_];
+		return location;
+	}
+
+	// Look [n] tokens past the current one without consuming anything.
+	THOR_FORCEINLINE Token peek(Ulen n = 1) const {
+		const auto last = tokens_.length() - 1;
+		return tokens_[cursor_ + n < last ? cursor_ + n : last];
+	}
+
+	// A procedure body which was skipped, the tokens from [cursor] up to the
+	// matching '}' and the state of the parser when it was skipped.
+	struct Deferred {
+		AstRef<AstProcExpr> proc;
+		Ulen                cursor;
+		Bool                allow_in_expr;
+	};
 
-	System&            sys_;
-	TemporaryAllocator temporary_;
-	AstFile            ast_;
-	Lexer              lexer_;
-	Token              token_;
+	System&              sys_;
+	SourceManager&       sources_;
+	Diagnostics&         diagnostics_;
+	Diagnostics::Buffer* buffer_ = nullptr; // Made on the first error
+	Uint32               base_; // Source location of the first byte of the file
+	TemporaryAllocator   temporary_;
+	AstFile              ast_;
+	Input*               input_;
+	Bool                 owner_; // Destroys input_ when done
+	const Lexer&         lexer_;
+	const TokenStream&   tokens_;
+	const LiteralTable&  literals_;
+	Ulen                 cursor_ = 0;
+	Token                token_;
 	// >= 0: In Expression
 	// <  0: In Control Clause
-	Sint32             expr_level_ = 0;
-	Bool               allow_in_expr_ = false;
+	Sint32               expr_level_ = 0;
+	Bool                 allow_in_expr_ = false;
+	Bool                 defer_bodies_ = false;
+	Bool                 quiet_ = false; // Errors are not reported
+	Ulen                 errors_ = 0; // Also those not reported
+	Array<Deferred>      deferred_;
 };
 
 } // namespace Thor
@@ -0,0 +1,98 @@
+#include "util/system.h"
+
+#include "source.h"
+
+namespace Thor {
+
+Maybe<Uint32> SourceManager::add(StringView name, StringView input) {
+	if (input.length() >= 0xff'ff'ff'ff_ulen) {
+		return {};
+	}
+	// Lines are counted before taking the lock so that files added from many
+	// threads do not wait on each other's scans. The table is allocated from
+	// system_ rather than temporary_, which is only used with the lock held.
+	const auto length = Uint32(input.length());
+	LineTable lines{system_};
+	if (!lines.build(input)) {
+		return {};
+	}
+	lock_.lock(sys_);
+	Maybe<Uint32> result;
+	if (Uint64(next_) + length + 1 <= 0xff'ff'ff'ff_u64) {
+		auto ref = names_.insert(name);
+		if (ref && files_.push_back({ ref, next_, length, move(lines) })) {
+			result = Uint32 { next_ };
+			next_ += length + 1;
+		}
+	}
+	lock_.unlock(sys_);
+	return result;
+}
+
+Maybe<Uint32> SourceManager::lookup(Uint32 location) const {
+	// Find the last file which begins at or before [location].
+	Ulen lo = 0;
+	Ulen hi = files_.length();
+	while (lo < hi) {
+		const auto mid = lo + (hi - lo) / 2;
+		if (files_[mid].base <= location) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo == 0) {
+		return {};
+	}
+	const auto& file = files_[lo - 1];
+	if (location - file.base > file.length) {
+		return {};
+	}
+	return Uint32(lo - 1);
+}
+
+Maybe<SourceSpan> SourceManager::find(Uint32 location) {
+	lock_.lock(sys_);
+	Maybe<SourceSpan> result;
+	if (auto index = lookup(location)) {
+		result = SourceSpan { *index, location - files_[*index].base };
+	}
+	lock_.unlock(sys_);
+	return result;
+}
+
+SourcePosition SourceManager::position(Uint32 location) {
+	lock_.lock(sys_);
+	SourcePosition result;
+	if (auto index = lookup(location)) {
+		const auto& file = files_[*index];
+		result = file.lines.position(location - file.base);
+	}
+	lock_.unlock(sys_);
+	return result;
+}
+
+void SourceManager::describe(StringBuilder& builder, Uint32 location) {
+	lock_.lock(sys_);
+	if (auto index = lookup(location)) {
+		const auto& file = files_[*index];
+		const auto position = file.lines.position(location - file.base);
+		builder.put(names_[file.name]);
+		builder.put(':');
+		builder.put(position.line);
+		builder.put(':');
+		builder.put(position.column);
+	} else {
+		builder.put("<unknown>");
+	}
+	lock_.unlock(sys_);
+}
+
+Ulen SourceManager::length() {
+	lock_.lock(sys_);
+	const auto result = files_.length();
+	lock_.unlock(sys_);
+	return result;
+}
+
+} // namespace Thor
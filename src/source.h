@@ -0,0 +1,82 @@
+#ifndef THOR_SOURCE_H
+#define THOR_SOURCE_H
+#include "util/lock.h"
+#include "util/string.h"
+
+#include "lexer.h"
+
+namespace Thor {
+
+// A file and an offset into it, what a source location stands for.
+struct SourceSpan {
+	Uint32 file;   // Index of the file in the SourceManager
+	Uint32 offset; // Byte offset into that file
+};
+
+// All of the source of a build shares one 32-bit location space. Every file
+// added to the SourceManager is given the next contiguous range of locations,
+// one for each byte of it and one more for the end of the file, so a single
+// Uint32 names both a file and an offset into it. Nodes of the AST hold these
+// locations, so diagnostics, debug info and caches which span files can pass
+// around just one integer.
+//
+// Location zero is never given out and stands for no location. The space fits
+// 4 GiB of source in total which is more than any build will ever load.
+//
+// Files are found from a location with a binary search over the ranges. Files
+// may be added and locations looked up from any thread.
+struct SourceManager {
+	static constexpr const Uint32 NONE = 0;
+
+	SourceManager(System& sys)
+		: sys_{sys}
+		, system_{sys}
+		, temporary_{system_}
+		, names_{temporary_}
+		, files_{temporary_}
+	{
+	}
+	SourceManager(const SourceManager&) = delete;
+	SourceManager(SourceManager&&) = delete;
+
+	// Give the file [name] with the contents [input] the next range of locations.
+	// The result is the location of its first byte, add the offset of something
+	// in the file to it for its location. Missing when out of memory or there are
+	// no more locations.
+	Maybe<Uint32> add(StringView name, StringView input);
+
+	// The file and offset of [location], missing when it is not in any file.
+	Maybe<SourceSpan> find(Uint32 location);
+
+	// Line and column of [location], zero when it is not in any file.
+	SourcePosition position(Uint32 location);
+
+	// Write [location] to [builder] as "file:line:column".
+	void describe(StringBuilder& builder, Uint32 location);
+
+	// The number of files added so far.
+	Ulen length();
+
+private:
+	struct File {
+		StringRef name;
+		Uint32    base;   // Location of the first byte
+		Uint32    length; // Length of the input, there is one more location
+		LineTable lines;
+	};
+
+	// Index of the file holding [location] with the lock held.
+	Maybe<Uint32> lookup(Uint32 location) const;
+
+	System&            sys_;
+	SystemAllocator    system_;
+	TemporaryAllocator temporary_; // Only used with lock_ held
+	Lock               lock_;
+	StringTable        names_;
+	Array<File>        files_;     // Ordered by base
+	Uint32             next_ = 1;  // The next location to give out
+};
+
+} // namespace Thor
+
+#endif // THOR_SOURCE_H
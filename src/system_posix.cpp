@@ -159,9 +159,33 @@ static void heap_deallocate(System&, void *addr, [[maybe_unused]] Ulen length) {
 #endif
 }
 
+static void* heap_reserve(System&, Ulen length) {
+	auto addr = mmap(nullptr,
+	                 length,
+	                 PROT_NONE,
+	                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+	                 -1,
+	                 0);
+	if (addr == MAP_FAILED) {
+		return nullptr;
+	}
+	return addr;
+}
+
+static Bool heap_commit(System&, void* addr, Ulen length) {
+	return mprotect(addr, length, PROT_READ | PROT_WRITE) == 0;
+}
+
+static void heap_release(System&, void* addr, Ulen length) {
+	munmap(addr, length);
+}
+
 extern const Heap STD_HEAP = {
 	.allocate   = heap_allocate,
 	.deallocate = heap_deallocate,
+	.reserve    = heap_reserve,
+	.commit     = heap_commit,
+	.release    = heap_release,
 };
 
 static void console_write(System&, StringView data) {
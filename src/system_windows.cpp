@@ -295,9 +295,25 @@ static void heap_deallocate(System&, void *address, [[maybe_unused]] Ulen length
 #endif
 }
 
+static void* heap_reserve(System&, Ulen length) {
+	return VirtualAlloc(nullptr, length, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+static Bool heap_commit(System&, void* addr, Ulen length) {
+	return VirtualAlloc(addr, length, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+static void heap_release(System&, void* addr, Ulen) {
+	// The whole reservation is released which must be given as a length of zero.
+	VirtualFree(addr, 0, MEM_RELEASE);
+}
+
 extern const Heap STD_HEAP = {
 	.allocate   = heap_allocate,
 	.deallocate = heap_deallocate,
+	.reserve    = heap_reserve,
+	.commit     = heap_commit,
+	.release    = heap_release,
 };
 
 static void console_write(System&, StringView data) {
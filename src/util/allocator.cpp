@@ -140,8 +140,20 @@ Address ArenaAllocator::grow(Address src_addr, Ulen req_old_len, Ulen req_new_le
 	return dst_addr;
 }
 
+void ArenaAllocator::rewind(Address cursor) {
+	ASSERT(cursor >= region_.beg && cursor <= cursor_);
+	ASAN_POISON_MEMORY_REGION(cursor, cursor_ - cursor);
+	VALGRIND_MAKE_MEM_NOACCESS(cursor, cursor_ - cursor);
+	cursor_ = cursor;
+}
+
 TemporaryAllocator::~TemporaryAllocator() {
-	for (auto node = tail_; node; /**/) {
+	// The blocks after the tail were rewound and are kept, free from the end.
+	auto last = tail_;
+	while (last && last->next_) {
+		last = last->next_;
+	}
+	for (auto node = last; node; /**/) {
 		const auto addr = reinterpret_cast<Address>(node);
 		const auto prev = node->prev_;
 		allocator_.free(addr, sizeof(Block) + node->arena_.length());
@@ -149,6 +161,27 @@ TemporaryAllocator::~TemporaryAllocator() {
 	}
 }
 
+TemporaryAllocator::Mark TemporaryAllocator::mark() const {
+	return { tail_, tail_ ? tail_->arena_.cursor() : 0 };
+}
+
+void TemporaryAllocator::rewind(Mark mark) {
+	// Empty every block which was moved on to after the mark was made.
+	auto block = mark.block ? mark.block : head_;
+	if (!block) {
+		return;
+	}
+	for (auto node = tail_; node != block; node = node->prev_) {
+		node->arena_.reset();
+	}
+	if (mark.block) {
+		block->arena_.rewind(mark.cursor);
+	} else {
+		block->arena_.reset();
+	}
+	tail_ = block;
+}
+
 Bool TemporaryAllocator::add(Ulen len) {
 	// 2 MiB chunks and double in size until large enough for 'len'
 	Ulen block_size = 2 << 20;
@@ -161,6 +194,10 @@ Bool TemporaryAllocator::add(Ulen len) {
 	}
 	const auto ptr = reinterpret_cast<void*>(addr);
 	const auto node = new (ptr, Nat{}) Block{block_size};
+	// Every block after the tail was too small so the new one goes at the end.
+	while (tail_ && tail_->next_) {
+		tail_ = tail_->next_;
+	}
 	if (tail_) {
 		tail_->next_ = node;
 		node->prev_ = tail_;
@@ -181,6 +218,14 @@ Address TemporaryAllocator::alloc(Ulen new_len, Bool zero) {
 	if (const auto addr = tail_->arena_.alloc(new_len, zero)) {
 		return addr;
 	}
+	// Move on to a block kept from an earlier rewind when there is one large
+	// enough.
+	for (auto node = tail_->next_; node; node = node->next_) {
+		if (const auto addr = node->arena_.alloc(new_len, zero)) {
+			tail_ = node;
+			return addr;
+		}
+	}
 	if (!add(new_len)) {
 		return 0;
 	}
@@ -66,6 +66,12 @@ struct ArenaAllocator : Allocator {
 	constexpr Ulen length() const {
 		return region_.end - region_.beg;
 	}
+	constexpr Address cursor() const {
+		return cursor_;
+	}
+	// Give back everything allocated after [cursor] at once.
+	void rewind(Address cursor);
+	void reset() { rewind(region_.beg); }
 private:
 	struct { Address beg, end; } region_;
 	Address                      cursor_;
@@ -84,6 +90,31 @@ private:
 };
 
 struct TemporaryAllocator : Allocator {
+private:
+	struct Block;
+public:
+	// The top of the allocator. Rewinding to a mark gives back everything which
+	// was allocated after it was made, marks are rewound in the opposite order to
+	// which they were made. Blocks given back are kept to be used again.
+	struct Mark {
+		Block*  block;
+		Address cursor;
+	};
+	// Rewinds to the mark made on construction when it goes out of scope, which
+	// is after anything declared later in the same scope has been destroyed.
+	struct Scope {
+		Scope(TemporaryAllocator& allocator)
+			: allocator_{allocator}
+			, mark_{allocator.mark()}
+		{
+		}
+		Scope(const Scope&) = delete;
+		~Scope() { allocator_.rewind(mark_); }
+	private:
+		TemporaryAllocator& allocator_;
+		Mark                mark_;
+	};
+
 	TemporaryAllocator(const TemporaryAllocator&) = delete;
 	TemporaryAllocator(TemporaryAllocator&& other)
 		: allocator_{other.allocator_}
@@ -100,6 +131,8 @@ struct TemporaryAllocator : Allocator {
 	virtual void free(Address addr, Ulen old_len);
 	virtual void shrink(Address addr, Ulen old_len, Ulen new_len);
 	virtual Address grow(Address addr, Ulen old_len, Ulen new_len, Bool zero);
+	Mark mark() const;
+	void rewind(Mark mark);
 private:
 	// Add a new block to the temporary allocator.
 	Bool add(Ulen len);
@@ -115,7 +148,7 @@ private:
 	};
 	Allocator& allocator_;
 	Block*     head_ = nullptr;
-	Block*     tail_ = nullptr;
+	Block*     tail_ = nullptr; // Blocks after this one are empty
 };
 
 template<Ulen E>
@@ -168,6 +201,8 @@ private:
 	TemporaryAllocator temporary_;
 };
 
+// Allocates straight from System::heap, so unlike the TemporaryAllocator of
+// System::allocator it can be shared by many threads.
 struct SystemAllocator : Allocator {
 	constexpr SystemAllocator(System& sys)
 		: sys_{sys}
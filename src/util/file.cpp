@@ -51,12 +51,13 @@ void File::close() {
 	}
 }
 
-Array<Uint8> File::map(Allocator& allocator) const {
+Array<Uint8> File::map(Allocator& allocator, Ulen padding) const {
 	Array<Uint8> result{allocator};
-	if (!result.resize(tell())) {
+	const auto length = tell();
+	if (!result.resize(length + padding)) {
 		return {allocator};
 	}
-	if (read(0, result.slice()) != result.length()) {
+	if (read(0, result.slice().truncate(length)) != length) {
 		return {allocator};
 	}
 	return result;
@@ -29,7 +29,9 @@ struct File {
 
 	void close();
 
-	Array<Uint8> map(Allocator& allocator) const;
+	// Read the whole file into memory followed by [padding] zero bytes. The
+	// length of the result includes the padding.
+	Array<Uint8> map(Allocator& allocator, Ulen padding = 0) const;
 
 private:
 	File* drop() {
@@ -0,0 +1,124 @@
+#include <string.h> // memcpy
+
+#include "util/region.h"
+#include "util/system.h"
+#include "util/stream.h"
+
+namespace Thor {
+
+// The serialized representation of the Region
+struct RegionHeader {
+	Uint8  magic[4]; // 'rgon'
+	Uint32 version;
+	Uint64 size;
+	Uint64 length;
+};
+// Following the header:
+// 	Uint8 data[RegionHeader::size * RegionHeader::length]
+static_assert(sizeof(RegionHeader) == 24);
+
+// Memory is committed in steps of at least this many bytes, doubling what is
+// committed each time so that growing takes few calls into the system.
+static constexpr const Ulen COMMIT = 64 * 1024;
+
+static constexpr Ulen round_up(Ulen value, Ulen to) {
+	return (value + (to - 1)) / to * to;
+}
+
+Maybe<Region> Region::create(System& sys, Ulen size, Ulen capacity) {
+	const auto bytes = round_up(size * capacity, COMMIT);
+	auto data = sys.heap.reserve(sys, bytes);
+	if (!data) {
+		return {};
+	}
+	return Region { sys, static_cast<Uint8*>(data), size, capacity };
+}
+
+Maybe<Region> Region::load(System& sys, Stream& stream, Ulen size, Ulen capacity) {
+	RegionHeader header;
+	if (!stream.read(Slice{&header, 1}.cast<Uint8>())) {
+		return {};
+	}
+	if (Slice<const Uint8>{header.magic} != Slice{"rgon"}.cast<const Uint8>()) {
+		return {};
+	}
+	if (header.version != 1 || header.size != size || header.length > capacity) {
+		return {};
+	}
+	auto region = create(sys, Ulen(header.size), capacity);
+	if (!region || !region->reserve(Ulen(header.length))) {
+		return {};
+	}
+	region->length_ = Ulen(header.length);
+	if (!stream.read(Slice{region->data_, region->size_ * region->length_})) {
+		return {};
+	}
+	return region;
+}
+
+Bool Region::save(Stream& stream) const {
+	RegionHeader header = {
+		.magic   = { 'r', 'g', 'o', 'n' },
+		.version = 1,
+		.size    = Uint64(size_),
+		.length  = Uint64(length_),
+	};
+	return stream.write(Slice{&header, 1}.cast<const Uint8>())
+	    && stream.write(Slice{data_, size_ * length_}.cast<const Uint8>());
+}
+
+Region::~Region() {
+	if (data_) {
+		sys_.heap.release(sys_, data_, round_up(size_ * capacity_, COMMIT));
+	}
+}
+
+Bool Region::reserve(Ulen length) {
+	const auto needed = size_ * length;
+	if (needed <= committed_) {
+		return true;
+	}
+	if (length > capacity_) {
+		return false;
+	}
+	const auto limit = round_up(size_ * capacity_, COMMIT);
+	auto bytes = committed_ ? committed_ * 2 : COMMIT;
+	if (bytes < needed) {
+		bytes = round_up(needed, COMMIT);
+	}
+	if (bytes > limit) {
+		bytes = limit;
+	}
+	if (!sys_.heap.commit(sys_, data_ + committed_, bytes - committed_)) {
+		return false;
+	}
+	committed_ = bytes;
+	return true;
+}
+
+Maybe<Uint32> Region::allocate() {
+	if (!reserve(length_ + 1)) {
+		return {};
+	}
+	return Uint32(length_++);
+}
+
+Maybe<Uint32> Region::append(const Region& other, Slice<const Uint32> skip) {
+	if (other.size_ != size_ || !reserve(length_ + other.length_ - skip.length())) {
+		return {};
+	}
+	auto offset = Uint32(length_);
+	// Copy the runs of objects between those skipped.
+	Ulen from = 0;
+	for (Ulen i = 0; i <= skip.length(); i++) {
+		const Ulen to = i < skip.length() ? skip[i] : other.length_;
+		if (to > from) {
+			memcpy(data_ + size_ * length_, other.data_ + size_ * from, size_ * (to - from));
+			length_ += to - from;
+		}
+		from = to + 1;
+	}
+	return offset;
+}
+
+} // namespace Thor
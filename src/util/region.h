@@ -0,0 +1,84 @@
+#ifndef THOR_REGION_H
+#define THOR_REGION_H
+#include "util/maybe.h"
+#include "util/exchange.h"
+#include "util/slice.h"
+
+namespace Thor {
+
+struct System;
+struct Stream;
+
+// Objects of one fixed size laid out one after another in a single range of
+// reserved address space. Memory is committed to the range as it grows, so an
+// object never moves and is found from its index with one multiply. Objects are
+// only ever added, there is no deallocate. It communicates in plain indices
+// rather than pointers.
+struct Region {
+	// A region for up to [capacity] objects of [size] bytes. Reserving address
+	// space is cheap, memory is only used for the objects allocated.
+	static Maybe<Region> create(System& sys, Ulen size, Ulen capacity);
+
+	// Load a region saved by save. Missing when its objects are not of [size]
+	// bytes or there are more than [capacity] of them.
+	static Maybe<Region> load(System& sys, Stream& stream, Ulen size, Ulen capacity);
+	Bool save(Stream& stream) const;
+
+	Region(Region&& other)
+		: sys_{other.sys_}
+		, data_{exchange(other.data_, nullptr)}
+		, size_{exchange(other.size_, 0)}
+		, length_{exchange(other.length_, 0)}
+		, capacity_{exchange(other.capacity_, 0)}
+		, committed_{exchange(other.committed_, 0)}
+	{
+	}
+	~Region();
+
+	// The index of a new zeroed object, missing when the region is full or out
+	// of memory.
+	Maybe<Uint32> allocate();
+
+	// Copy every object of [other] after those of this region, except for those
+	// whose indices are in [skip] in ascending order. The result is the index in
+	// this of the first object copied, the others follow it in order.
+	Maybe<Uint32> append(const Region& other, Slice<const Uint32> skip = {});
+
+	[[nodiscard]] THOR_FORCEINLINE constexpr Ulen size() const { return size_; }
+	[[nodiscard]] THOR_FORCEINLINE constexpr Ulen length() const { return length_; }
+	[[nodiscard]] THOR_FORCEINLINE constexpr Uint8* data() const { return data_; }
+
+	THOR_FORCEINLINE constexpr Uint8* operator[](Uint32 index) { return data_ + size_ * index; }
+	THOR_FORCEINLINE constexpr const Uint8* operator[](Uint32 index) const { return data_ + size_ * index; }
+
+	// Call [fn] with the address of every object from index [from] on.
+	template<typename F>
+	void each(Uint32 from, F&& fn) {
+		for (Ulen i = from; i < length_; i++) {
+			fn(data_ + size_ * i);
+		}
+	}
+
+private:
+	constexpr Region(System& sys, Uint8* data, Ulen size, Ulen capacity)
+		: sys_{sys}
+		, data_{data}
+		, size_{size}
+		, capacity_{capacity}
+	{
+	}
+
+	// Commit enough memory for [length] objects.
+	Bool reserve(Ulen length);
+
+	System& sys_;
+	Uint8*  data_;          // Start of the reserved range
+	Ulen    size_;          // Size of an object
+	Ulen    length_ = 0;    // # of objects
+	Ulen    capacity_;      // Max # of objects there is address space for
+	Ulen    committed_ = 0; // # of bytes committed from data_ on
+};
+
+} // namespace Thor
+
+#endif // THOR_REGION_H
@@ -0,0 +1,187 @@
+#ifndef THOR_SIMD_H
+#define THOR_SIMD_H
+#include "util/types.h"
+
+// Pick the widest vector extension the target is compiled for. We only depend
+// on what the compiler has been told is available, there is no runtime dispatch.
+#if defined(__AVX2__)
+	#define THOR_SIMD_AVX2
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define THOR_SIMD_SSE2
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+	#define THOR_SIMD_NEON
+	#include <arm_neon.h>
+#else
+	#define THOR_SIMD_SCALAR
+#endif
+
+#if defined(THOR_COMPILER_MSVC)
+	#include <intrin.h>
+#endif
+
+namespace Thor {
+
+// Count the number of trailing zero bits in [value] which is the same as giving
+// the index to the first non-zero bit. The result is undefined for zero.
+THOR_FORCEINLINE Uint32 count_trailing_zeros64(Uint64 value) {
+#if defined(THOR_COMPILER_MSVC)
+	unsigned long index = 0;
+	_BitScanForward64(&index, value);
+	return index;
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+// Count the number of leading zero bits in [value]. The result is undefined for
+// zero.
+THOR_FORCEINLINE Uint32 count_leading_zeros64(Uint64 value) {
+#if defined(THOR_COMPILER_MSVC)
+	unsigned long index = 0;
+	_BitScanReverse64(&index, value);
+	return 63 - index;
+#else
+	return __builtin_clzll(value);
+#endif
+}
+
+// Count the number of bits set in [value].
+THOR_FORCEINLINE Uint32 count_ones64(Uint64 value) {
+#if defined(THOR_COMPILER_MSVC)
+	return Uint32(__popcnt64(value));
+#else
+	return __builtin_popcountll(value);
+#endif
+}
+
+// A 64-byte block of input held in vector registers. Every query produces a
+// 64-bit mask where bit N describes byte N of the block, this lets callers walk
+// the interesting bytes of a block with count_trailing_zeros64 instead of
+// testing every byte.
+struct SimdBlock {
+	static constexpr const Ulen SIZE = 64;
+
+	// Load 64 bytes from [data], which does not need to be aligned.
+	static THOR_FORCEINLINE SimdBlock load(const Uint8* data) {
+		SimdBlock block;
+#if defined(THOR_SIMD_AVX2)
+		block.v_[0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data +  0));
+		block.v_[1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+#elif defined(THOR_SIMD_SSE2)
+		for (Ulen i = 0; i < 4; i++) {
+			block.v_[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+		}
+#elif defined(THOR_SIMD_NEON)
+		for (Ulen i = 0; i < 4; i++) {
+			block.v_[i] = vld1q_u8(data + i * 16);
+		}
+#else
+		for (Ulen i = 0; i < SIZE; i++) {
+			block.v_[i] = data[i];
+		}
+#endif
+		return block;
+	}
+
+	// Load the [length] < SIZE bytes at [data], the rest of the block is filled
+	// with zeros. This is for the tail of a buffer which may not be read past.
+	static SimdBlock load_partial(const Uint8* data, Ulen length) {
+		Uint8 tail[SIZE] = {};
+		for (Ulen i = 0; i < length; i++) {
+			tail[i] = data[i];
+		}
+		return load(tail);
+	}
+
+	// Mask of the bytes which equal [byte].
+	THOR_FORCEINLINE Uint64 eq(Uint8 byte) const {
+#if defined(THOR_SIMD_AVX2)
+		const auto splat = _mm256_set1_epi8(static_cast<char>(byte));
+		const Uint64 lo = Uint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v_[0], splat)));
+		const Uint64 hi = Uint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v_[1], splat)));
+		return lo | (hi << 32);
+#elif defined(THOR_SIMD_SSE2)
+		const auto splat = _mm_set1_epi8(static_cast<char>(byte));
+		Uint64 mask = 0;
+		for (Ulen i = 0; i < 4; i++) {
+			const Uint64 bits = Uint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v_[i], splat)));
+			mask |= bits << (i * 16);
+		}
+		return mask;
+#elif defined(THOR_SIMD_NEON)
+		const auto splat = vdupq_n_u8(byte);
+		return movemask(vceqq_u8(v_[0], splat),
+		                vceqq_u8(v_[1], splat),
+		                vceqq_u8(v_[2], splat),
+		                vceqq_u8(v_[3], splat));
+#else
+		Uint64 mask = 0;
+		for (Ulen i = 0; i < SIZE; i++) {
+			mask |= Uint64(v_[i] == byte) << i;
+		}
+		return mask;
+#endif
+	}
+
+	// Mask of the bytes with the top bit set, i.e the bytes which are not ASCII.
+	THOR_FORCEINLINE Uint64 high() const {
+#if defined(THOR_SIMD_AVX2)
+		const Uint64 lo = Uint32(_mm256_movemask_epi8(v_[0]));
+		const Uint64 hi = Uint32(_mm256_movemask_epi8(v_[1]));
+		return lo | (hi << 32);
+#elif defined(THOR_SIMD_SSE2)
+		Uint64 mask = 0;
+		for (Ulen i = 0; i < 4; i++) {
+			const Uint64 bits = Uint16(_mm_movemask_epi8(v_[i]));
+			mask |= bits << (i * 16);
+		}
+		return mask;
+#elif defined(THOR_SIMD_NEON)
+		const auto splat = vdupq_n_u8(0x80);
+		return movemask(vcgeq_u8(v_[0], splat),
+		                vcgeq_u8(v_[1], splat),
+		                vcgeq_u8(v_[2], splat),
+		                vcgeq_u8(v_[3], splat));
+#else
+		Uint64 mask = 0;
+		for (Ulen i = 0; i < SIZE; i++) {
+			mask |= Uint64(v_[i] >> 7) << i;
+		}
+		return mask;
+#endif
+	}
+
+private:
+#if defined(THOR_SIMD_NEON)
+	// NEON has no movemask, so isolate a distinct bit for each lane and then sum
+	// neighbouring lanes together until every lane contributes a single bit.
+	static THOR_FORCEINLINE Uint64 movemask(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3) {
+		static constexpr const Uint8 BITS[16] = {
+			0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+			0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+		};
+		const auto bits = vld1q_u8(BITS);
+		auto sum0 = vpaddq_u8(vandq_u8(m0, bits), vandq_u8(m1, bits));
+		auto sum1 = vpaddq_u8(vandq_u8(m2, bits), vandq_u8(m3, bits));
+		sum0 = vpaddq_u8(sum0, sum1);
+		sum0 = vpaddq_u8(sum0, sum0);
+		return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+	}
+#endif
+
+#if defined(THOR_SIMD_AVX2)
+	__m256i v_[2];
+#elif defined(THOR_SIMD_SSE2)
+	__m128i v_[4];
+#elif defined(THOR_SIMD_NEON)
+	uint8x16_t v_[4];
+#else
+	Uint8 v_[SIZE];
+#endif
+};
+
+} // namespace Thor
+
+#endif // THOR_SIMD_H
@@ -35,6 +35,12 @@ struct Filesystem {
 struct Heap {
 	void *(*allocate)(System& sys, Ulen len, Bool zero);
 	void (*deallocate)(System& sys, void* addr, Ulen len);
+	// Reserve [len] bytes of address space without any memory behind it. Ranges
+	// of it are made usable with commit, which are zeroed. All of it is given back
+	// with release.
+	void *(*reserve)(System& sys, Ulen len);
+	Bool (*commit)(System& sys, void* addr, Ulen len);
+	void (*release)(System& sys, void* addr, Ulen len);
 };
 
 struct Console {
@@ -102,6 +108,11 @@ public:
 		, allocator{allocator_}
 	{
 	}
+	// A System with the same interfaces and an allocator of its own, e.g. for a
+	// thread as the allocator is not thread safe.
+	System clone() const {
+		return System { filesystem, heap, console, process, linker, scheduler, chrono };
+	}
 	const Filesystem&  filesystem;
 	const Heap&        heap;
 	const Console&     console;
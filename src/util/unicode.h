@@ -1,6 +1,6 @@
 #ifndef THOR_UNICODE_H
 #define THOR_UNICODE_H
-#include "util/types.h"
+#include "util/slice.h"
 
 namespace Thor {
 
@@ -11,11 +11,26 @@ struct Rune {
 	[[nodiscard]] Bool is_digit(Uint32 base) const;
 	[[nodiscard]] Bool is_alpha() const;
 	[[nodiscard]] Bool is_white() const;
+	// The XID_Start and XID_Continue properties, which is what Unicode suggests
+	// identifiers should be made of.
+	[[nodiscard]] Bool is_xid_start() const;
+	[[nodiscard]] Bool is_xid_continue() const;
 	operator Uint32() const { return v_; }
 private:
 	Uint32 v_;
 };
 
+enum class Encoding : Uint8 {
+	INVALID, // Not well formed UTF-8
+	ASCII,   // Every byte is ASCII, which is also UTF-8
+	UTF8,    // Well formed UTF-8 with at least one multi-byte sequence
+};
+
+// Check all of [data] in one go. Well formed rules out truncated sequences,
+// overlong encodings, surrogates and anything past U+10FFFF, so a decoder over
+// the same data does not need to check any of that again.
+Encoding classify_utf8(Slice<const Uint8> data);
+
 } // namespace Thor
 
 #endif // THOR_UNICODE
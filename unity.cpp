@@ -12,17 +12,20 @@
 #include "src/util/cpprt.cpp"
 #include "src/util/file.cpp"
 #include "src/util/lock.cpp"
-#include "src/util/pool.cpp"
-#include "src/util/slab.cpp"
+#include "src/util/region.cpp"
 #include "src/util/stream.cpp"
 #include "src/util/string.cpp"
 #include "src/util/thread.cpp"
 #include "src/util/time.cpp"
 #include "src/util/unicode.cpp"
 #include "src/ast.cpp"
+#include "src/diagnostic.cpp"
 #include "src/lexer.cpp"
+#include "src/literal.cpp"
 #include "src/main.cpp"
+#include "src/package.cpp"
 #include "src/parser.cpp"
+#include "src/source.cpp"
 #include "src/cg_llvm.cpp"
 #include "src/system_posix.cpp"
 #include "src/system_windows.cpp"